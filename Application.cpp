@@ -50,11 +50,15 @@ Application::Application(char *infile) {
 	par = new Params();
 	srand (time(NULL));
 	par->setparams(infile);
+	setRingHash(par->RING_HASH);
 	log = new Log(par);
 	en = new EmulNet(par);
 	en1 = new EmulNet(par);
 	mp1 = (MP1Node **) malloc(par->EN_GPSZ * sizeof(MP1Node *));
 	mp2 = (MP2Node **) malloc(par->EN_GPSZ * sizeof(MP2Node *));
+	failedAt.assign(par->EN_GPSZ, -1);
+	restartedAt.assign(par->EN_GPSZ, -1);
+	restartedNode = -1;
 
 	/*
 	 * Init all nodes
@@ -99,6 +103,7 @@ int Application::run()
 {
 	int i;
 	int timeWhenAllNodesHaveJoined = 0;
+	int timeWhenMembershipConverged = -1;
 	// boolean indicating if all nodes have joined
 	bool allNodesJoined = false;
 	srand(time(NULL));
@@ -108,6 +113,10 @@ int Application::run()
 		// Run the membership protocol
 		mp1Run();
 
+		if ( timeWhenMembershipConverged < 0 && membershipConverged() ) {
+			timeWhenMembershipConverged = par->getcurrtime();
+		}
+
 		// Wait for all nodes to join
 		if ( par->allNodesJoined == nodeCount && !allNodesJoined ) {
 			timeWhenAllNodesHaveJoined = par->getcurrtime();
@@ -117,10 +126,17 @@ int Application::run()
 			// Call the KV store functionalities
 			mp2Run();
 		}
-		// Fail some nodes
-		//fail();
+		// Fail some nodes. Config files without a CRUD test are membership scenarios
+		if ( NO_TEST == par->CRUDTEST ) {
+			fail();
+		}
+
+		recordFailures();
     }
 
+	reportMembershipStats(timeWhenMembershipConverged);
+	reportDetectorStats();
+
     // Clean up
 	en->ENcleanup();
 	en1->ENcleanup();
@@ -182,6 +198,123 @@ void Application::mp1Run() {
 	}
 }
 
+/**
+ * FUNCTION NAME: membershipConverged
+ *
+ * DESCRIPTION: True once every node has been introduced and every alive node
+ * 				knows about all the other alive nodes
+ */
+bool Application::membershipConverged() {
+	int i;
+	unsigned int alive = 0;
+
+	for ( i = 0; i < par->EN_GPSZ; i++ ) {
+		Member *memberNode = mp1[i]->getMemberNode();
+		if ( !memberNode->inited ) {
+			return false;
+		}
+		if ( !memberNode->bFailed ) {
+			alive++;
+		}
+	}
+
+	for ( i = 0; i < par->EN_GPSZ; i++ ) {
+		Member *memberNode = mp1[i]->getMemberNode();
+		if ( !memberNode->bFailed && (!memberNode->inGroup || memberNode->memberList.size() < alive - 1) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: reportMembershipStats
+ *
+ * DESCRIPTION: Report the membership convergence time and the bytes each node
+ * 				sent and received for the membership protocol
+ */
+void Application::reportMembershipStats(int timeWhenMembershipConverged) {
+	unsigned long totalBytes = 0;
+
+	if ( timeWhenMembershipConverged >= 0 ) {
+		cout<<endl<<"Membership converged at time: "<<timeWhenMembershipConverged<<endl;
+	}
+	else {
+		cout<<endl<<"Membership did not converge"<<endl;
+	}
+	log->LOG(&mp1[0]->getMemberNode()->addr, "#STATSLOG# membership converged at time %d (fanout %d, period %d)", timeWhenMembershipConverged, par->GOSSIP_FANOUT, par->GOSSIP_PERIOD);
+
+	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
+		Address *addr = &mp1[i]->getMemberNode()->addr;
+		en_counters *counters = en->ENcounters(addr);
+		if ( counters == NULL ) {
+			continue;
+		}
+		log->LOG(addr, "#STATSLOG# membership sent_bytes %lu recv_bytes %lu", counters->sent_bytes, counters->recv_bytes);
+		totalBytes += counters->sent_bytes;
+	}
+	cout<<"Membership bytes sent per node: "<<totalBytes / par->EN_GPSZ<<endl;
+}
+
+/**
+ * FUNCTION NAME: recordFailures
+ *
+ * DESCRIPTION: Note the time at which each node failed
+ */
+void Application::recordFailures() {
+	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
+		if ( failedAt[i] < 0 && mp1[i]->getMemberNode()->bFailed ) {
+			failedAt[i] = par->getcurrtime();
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: reportDetectorStats
+ *
+ * DESCRIPTION: Report how long alive nodes took to remove failed nodes, and how many
+ * 				removals hit nodes that were not down at the time (false positives): before
+ * 				they failed, or after they were restarted
+ */
+void Application::reportDetectorStats() {
+	map<string, int> nodeIndex;
+	unsigned long detections = 0;
+	unsigned long falsePositives = 0;
+	long totalLatency = 0;
+	long maxLatency = 0;
+
+	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
+		nodeIndex[mp1[i]->getMemberNode()->addr.getAddress()] = i;
+	}
+
+	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
+		const vector<MemberRemoval> &removals = mp1[i]->getRemovals();
+		for ( unsigned int j = 0; j < removals.size(); j++ ) {
+			Address removed = removals[j].addr;
+			int target = nodeIndex[removed.getAddress()];
+			int failed = failedAt[target];
+			int restarted = restartedAt[target];
+			if ( failed < 0 || removals[j].time < failed || (restarted >= 0 && removals[j].time >= restarted) ) {
+				falsePositives++;
+			}
+			else if ( failedAt[i] < 0 || restartedAt[i] >= 0 ) {
+				// Only detections by nodes that are alive count towards latency; a restarted node
+				// only holds the removals it made after its restart
+				long latency = removals[j].time - failed;
+				totalLatency += latency;
+				maxLatency = max(maxLatency, latency);
+				detections++;
+			}
+		}
+	}
+
+	if ( detections > 0 ) {
+		cout<<"Failure detection latency: average "<<(double) totalLatency / detections<<", max "<<maxLatency<<" over "<<detections<<" detections"<<endl;
+	}
+	cout<<"Failure detector false positives: "<<falsePositives<<endl;
+	log->LOG(&mp1[0]->getMemberNode()->addr, "#STATSLOG# detector %d detections %lu total_latency %ld max_latency %ld false_positives %lu", par->FAILURE_DETECTOR, detections, totalLatency, maxLatency, falsePositives);
+}
+
 /**
  * FUNCTION NAME: mp2Run
  *
@@ -325,6 +458,40 @@ void Application::mp2Run() {
 			updateTest();
 		} // End of update test
 
+		/**************
+		 * BATCH TESTS
+		 **************/
+		/**
+		 * TEST 1: Read every key with one multiGet. Check for the correct value of each key
+		 * 		   being read in quorum of replicas
+		 *
+		 * TEST 2: Create NUMBER_OF_INSERTS/2 new keys with one multiPut. Check for RF * NUMBER_OF_INSERTS/2
+		 * 		   CREATE SUCCESS server messages in the log
+		 *
+		 * TEST 3: Delete half the keys and a non-existent key with one multiDelete. Check for
+		 * 		   RF DELETE SUCCESS server messages of each valid key, and a DELETE FAIL for the invalid key
+		 *
+		 */
+		else if ( par->getcurrtime() >= TEST_TIME && BATCH_TEST == par->CRUDTEST ) {
+			batchTest();
+		} // End of batch test
+
+		/***************
+		 * RESTART TEST
+		 ***************/
+		/**
+		 * Fail a node, wait STABILIZE_TIME for the others to remove it, and restart it. With WAL set
+		 * it rebuilds its keys from its write-ahead log. After another STABILIZE_TIME, read every key.
+		 *
+		 * TEST 1: The restarted node recovers the keys it held when it failed
+		 * TEST 2: The restarted node pulls none of those keys from its peers
+		 * TEST 3: Every key is read in quorum of replicas
+		 *
+		 */
+		else if ( par->getcurrtime() >= TEST_TIME && RESTART_TEST == par->CRUDTEST ) {
+			restartTest();
+		} // End of restart test
+
 	} // end of if ( par->getcurrtime == TEST_TIME)
 }
 
@@ -397,7 +564,7 @@ int Application::findARandomNodeThatIsAlive() {
 /**
  * FUNCTION NAME: initTestKVPairs
  *
- * DESCRIPTION: Init NUMBER_OF_INSERTS test KV pairs in the map
+ * DESCRIPTION: Init NUMBER_OF_INSERTS test KV pairs in the map, their values padded to VALUE_SIZE
  */
 void Application::initTestKVPairs() {
 	srand(time(NULL));
@@ -411,6 +578,9 @@ void Application::initTestKVPairs() {
 			key.push_back(alphanum[rand()%alphanumLen]);
 		}
 		string value = "value" + to_string(rand()%NUMBER_OF_INSERTS);
+		if ( (int) value.size() < par->VALUE_SIZE ) {
+			value.resize(par->VALUE_SIZE, 'x');
+		}
 		testKVPairs[key] = value;
 		key.clear();
 	}
@@ -477,6 +647,131 @@ void Application::deleteTest() {
 	mp2[number]->clientDelete(invalidKey);
 }
 
+/**
+ * FUNCTION NAME: batchTest
+ *
+ * DESCRIPTION: Test the batched multiGet, multiPut and multiDelete APIs of the KV store.
+ * 				Each step issues all its keys from a single coordinator.
+ */
+void Application::batchTest() {
+	int number;
+
+	/**
+	 * Test 1: Read every key in one multiGet
+	 */
+	if ( par->getcurrtime() == TEST_TIME ) {
+		vector<string> keys;
+		number = findARandomNodeThatIsAlive();
+		cout<<endl<<"Reading "<<testKVPairs.size()<<" keys in a batch.... ... .. . ."<<endl;
+		for ( map<string, string>::iterator it = testKVPairs.begin(); it != testKVPairs.end(); ++it ) {
+			log->LOG(&mp2[number]->getMemberNode()->addr, "READ OPERATION KEY: %s VALUE: %s at time: %d", it->first.c_str(), it->second.c_str(), par->getcurrtime());
+			keys.push_back(it->first);
+		}
+		mp2[number]->multiGet(keys);
+	}
+
+	/**
+	 * Test 2: Create new keys in one multiPut
+	 */
+	if ( par->getcurrtime() == TEST_TIME + STABILIZE_TIME ) {
+		map<string, string> newKVPairs;
+		number = findARandomNodeThatIsAlive();
+		cout<<endl<<"Creating "<<NUMBER_OF_INSERTS/2<<" keys in a batch.... ... .. . ."<<endl;
+		for ( int i = 0; i < NUMBER_OF_INSERTS/2; i++ ) {
+			// Test keys are KEY_LENGTH long, so these cannot clash with them
+			string key = "batchKey" + to_string(i);
+			newKVPairs[key] = "value" + to_string(i);
+			log->LOG(&mp2[number]->getMemberNode()->addr, "CREATE OPERATION KEY: %s VALUE: %s at time: %d", key.c_str(), newKVPairs[key].c_str(), par->getcurrtime());
+		}
+		mp2[number]->multiPut(newKVPairs);
+	}
+
+	/**
+	 * Test 3: Delete half the keys and a non-existent key in one multiDelete
+	 */
+	if ( par->getcurrtime() == TEST_TIME + 2 * STABILIZE_TIME ) {
+		vector<string> keys;
+		string invalidKey = "invalidKey";
+		number = findARandomNodeThatIsAlive();
+		cout<<endl<<"Deleting "<<testKVPairs.size()/2<<" valid keys and an invalid key in a batch.... ... .. . ."<<endl;
+		map<string, string>::iterator it = testKVPairs.begin();
+		for ( size_t i = 0; i < testKVPairs.size()/2; i++, it++ ) {
+			log->LOG(&mp2[number]->getMemberNode()->addr, "DELETE OPERATION KEY: %s VALUE: %s at time: %d", it->first.c_str(), it->second.c_str(), par->getcurrtime());
+			keys.push_back(it->first);
+		}
+		log->LOG(&mp2[number]->getMemberNode()->addr, "DELETE OPERATION KEY: %s at time: %d", invalidKey.c_str(), par->getcurrtime());
+		keys.push_back(invalidKey);
+		mp2[number]->multiDelete(keys);
+	}
+}
+
+/**
+ * FUNCTION NAME: restartTest
+ *
+ * DESCRIPTION: Test the recovery of a node restarted after a failure
+ */
+void Application::restartTest() {
+	int number;
+
+	/**
+	 * Step 1: Fail a node other than the introducer, which the restarted node rejoins through
+	 */
+	if ( par->getcurrtime() == TEST_TIME ) {
+		do {
+			restartedNode = findARandomNodeThatIsAlive();
+		} while ( restartedNode == 0 );
+		cout<<endl<<"Failing a node to restart it.... ... .. . ."<<endl;
+		log->LOG(&mp2[restartedNode]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
+		mp2[restartedNode]->getMemberNode()->bFailed = true;
+		mp1[restartedNode]->getMemberNode()->bFailed = true;
+	}
+
+	/**
+	 * Step 2: Restart it once the other nodes removed it
+	 */
+	if ( par->getcurrtime() == TEST_TIME + STABILIZE_TIME ) {
+		cout<<endl<<"Restarting the failed node.... ... .. . ."<<endl;
+		restartNode(restartedNode);
+	}
+
+	/**
+	 * Step 3: Read every key once it rejoined the ring
+	 */
+	if ( par->getcurrtime() == TEST_TIME + 2 * STABILIZE_TIME ) {
+		cout<<endl<<"Reading "<<testKVPairs.size()<<" keys.... ... .. . ."<<endl;
+		for ( map<string, string>::iterator it = testKVPairs.begin(); it != testKVPairs.end(); ++it ) {
+			number = findARandomNodeThatIsAlive();
+			log->LOG(&mp2[number]->getMemberNode()->addr, "READ OPERATION KEY: %s VALUE: %s at time: %d", it->first.c_str(), it->second.c_str(), par->getcurrtime());
+			mp2[number]->clientRead(it->first);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: restartNode
+ *
+ * DESCRIPTION: Restart a failed node at its address, as a new process would: its membership
+ * 				and key-value state and the messages sent to it while it was down are lost,
+ * 				and only its write-ahead log survives. It then joins the group again.
+ */
+void Application::restartNode(int node) {
+	Address address = mp1[node]->getMemberNode()->addr;
+
+	en->ENdiscard(&address);
+	en1->ENdiscard(&address);
+	delete mp1[node];
+	// Deletes the Member shared with mp1[node]
+	delete mp2[node];
+
+	Member *memberNode = new Member;
+	memberNode->inited = false;
+	mp1[node] = new MP1Node(memberNode, par, en, log, &address);
+	mp2[node] = new MP2Node(memberNode, par, en1, log, &address, true);
+	log->LOG(&address, "Node restarted at time=%d", par->getcurrtime());
+	mp1[node]->nodeStart(JOINADDR, par->PORTNUM);
+	restartedAt[node] = par->getcurrtime();
+}
+
 /**
  * FUNCTION NAME: readTest
  *
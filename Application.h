@@ -58,6 +58,12 @@ private:
 	MP2Node **mp2;
 	Params *par;
 	map<string, string> testKVPairs;
+	// Time each node failed at, -1 if it never failed
+	vector<int> failedAt;
+	// Time each failed node was restarted at, -1 if it was not
+	vector<int> restartedAt;
+	// Node the restart test fails and restarts
+	int restartedNode;
 public:
 	Application(char *);
 	virtual ~Application();
@@ -65,6 +71,10 @@ public:
 	void initTestKVPairs();
 	int run();
 	void mp1Run();
+	bool membershipConverged();
+	void reportMembershipStats(int timeWhenMembershipConverged);
+	void recordFailures();
+	void reportDetectorStats();
 	void mp2Run();
 	void fail();
 	void insertTestKVPairs();
@@ -72,6 +82,9 @@ public:
 	void deleteTest();
 	void readTest();
 	void updateTest();
+	void batchTest();
+	void restartTest();
+	void restartNode(int node);
 };
 
 #endif /* _APPLICATION_H__ */
@@ -9,60 +9,93 @@
 /**
  * Constructor
  */
-EmulNet::EmulNet(Params *p)
-{
-	//trace.funcEntry("EmulNet::EmulNet");
-	int i,j;
-	par = p;
-	emulnet.setNextId(1);
-	emulnet.settCurrBuffSize(0);
-	enInited=0;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			sent_msgs[i][j] = 0;
-			recv_msgs[i][j] = 0;
-		}
+ENPool::ENPool(int maxBlockSize): maxBlockSize(maxBlockSize) {
+	freeBlocks.resize(sizeClass(maxBlockSize) + 1);
+}
+
+/**
+ * Destructor
+ */
+ENPool::~ENPool() {
+	for ( unsigned int i = 0; i < slabs.size(); i++ ) {
+		free(slabs[i]);
 	}
-	//trace.funcExit("EmulNet::EmulNet", SUCCESS);
 }
 
 /**
- * Copy constructor
+ * FUNCTION NAME: sizeClass
+ *
+ * DESCRIPTION: Index of the smallest power-of-two class holding blockSize bytes
  */
-EmulNet::EmulNet(EmulNet &anotherEmulNet) {
-	int i, j;
-	this->par = anotherEmulNet.par;
-	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
-		}
+int ENPool::sizeClass(int blockSize) {
+	int index = 0;
+	int classSize = ENPOOL_MIN_BLOCK;
+	while ( classSize < blockSize ) {
+		classSize <<= 1;
+		index++;
 	}
-	this->emulnet = anotherEmulNet.emulnet;
+	return index;
 }
 
 /**
- * Assignment operator overloading
+ * FUNCTION NAME: alloc
+ *
+ * DESCRIPTION: Hand out a block of at least blockSize bytes, carving a new slab
+ * 				for the size class when its free list is empty
+ *
+ * RETURNS:
+ * pointer to the block, NULL if blockSize is above the pool limit
  */
-EmulNet& EmulNet::operator =(EmulNet &anotherEmulNet) {
-	int i, j;
-	this->par = anotherEmulNet.par;
-	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
+char *ENPool::alloc(int blockSize) {
+	if ( blockSize > maxBlockSize ) {
+		return NULL;
+	}
+	int index = sizeClass(blockSize);
+	vector<char *> &blocks = freeBlocks[index];
+
+	if ( blocks.empty() ) {
+		int classSize = ENPOOL_MIN_BLOCK << index;
+		char *slab = (char *) malloc(classSize * ENPOOL_SLAB_BLOCKS);
+		slabs.push_back(slab);
+		for ( int i = ENPOOL_SLAB_BLOCKS - 1; i >= 0; i-- ) {
+			blocks.push_back(slab + i * classSize);
 		}
 	}
-	this->emulnet = anotherEmulNet.emulnet;
-	return *this;
+
+	char *block = blocks.back();
+	blocks.pop_back();
+	return block;
+}
+
+/**
+ * FUNCTION NAME: release
+ *
+ * DESCRIPTION: Return a block obtained from alloc(blockSize) to its free list
+ */
+void ENPool::release(char *block, int blockSize) {
+	freeBlocks[sizeClass(blockSize)].push_back(block);
+}
+
+/**
+ * Constructor
+ */
+EmulNet::EmulNet(Params *p)
+{
+	//trace.funcEntry("EmulNet::EmulNet");
+	par = p;
+	pool = new ENPool(par->MAX_MSG_SIZE);
+	emulnet.setNextId(1);
+	emulnet.settCurrBuffSize(0);
+	enInited=0;
+	//trace.funcExit("EmulNet::EmulNet", SUCCESS);
 }
 
 /**
  * Destructor
  */
-EmulNet::~EmulNet() {}
+EmulNet::~EmulNet() {
+	delete pool;
+}
 
 /**
  * FUNCTION NAME: ENinit
@@ -77,46 +110,131 @@ void *EmulNet::ENinit(Address *myaddr, short port) {
 }
 
 /**
- * FUNCTION NAME: ENsend
+ * FUNCTION NAME: inboxKey
  *
- * DESCRIPTION: EmulNet send function
+ * DESCRIPTION: Pack the 6 byte address into the key of its inbox
+ */
+unsigned long long EmulNet::inboxKey(Address *addr) {
+	unsigned long long key = 0;
+	memcpy(&key, addr->addr, sizeof(addr->addr));
+	return key;
+}
+
+/**
+ * FUNCTION NAME: countMessage
+ *
+ * DESCRIPTION: Find the counters of this node for the current time unit,
+ * 				starting a new one if this is its first message in that time unit
  *
  * RETURNS:
- * size
+ * pointer to the counters of the current time unit
+ */
+en_tick *EmulNet::countMessage(Address *addr) {
+	int node = *(int *)(addr->addr);
+	int time = par->getcurrtime();
+
+	if ( node >= (int) msgStats.size() ) {
+		msgStats.resize(node + 1);
+	}
+
+	vector<en_tick> &series = msgStats[node].series;
+	if ( series.empty() || series.back().time != time ) {
+		en_tick tick = { time, 0, 0 };
+		series.push_back(tick);
+	}
+	return &series.back();
+}
+
+/**
+ * FUNCTION NAME: ENmaxPayload
+ *
+ * DESCRIPTION: Largest payload that fits in a message of MAX_MSG_SIZE
  */
-int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
+int EmulNet::ENmaxPayload() {
+	return par->MAX_MSG_SIZE - (int)sizeof(en_msg) - 1;
+}
+
+/**
+ * FUNCTION NAME: ENbuffer
+ *
+ * DESCRIPTION: Reserve a pooled send buffer for up to size bytes of payload,
+ * 				so that the caller can encode the message directly into it.
+ * 				The buffer must be passed to ENsendBuffer (or ENrelease).
+ *
+ * RETURNS:
+ * pointer to the payload area, NULL if size is above ENmaxPayload
+ */
+char *EmulNet::ENbuffer(int size) {
 	en_msg *em;
+
+	if ( size > ENmaxPayload() ) {
+		return NULL;
+	}
+
+	em = (en_msg *)pool->alloc(sizeof(en_msg) + size);
+	em->size = 0;
+	em->capacity = size;
+	return (char *)(em + 1);
+}
+
+/**
+ * FUNCTION NAME: ENsendBuffer
+ *
+ * DESCRIPTION: Send the first size bytes of a buffer obtained from ENbuffer.
+ * 				Ownership of the buffer passes to EmulNet whether or not the
+ * 				message gets through.
+ *
+ * RETURNS:
+ * size
+ */
+int EmulNet::ENsendBuffer(Address *myaddr, Address *toaddr, char *buffer, int size) {
+	en_msg *em = (en_msg *)buffer - 1;
 	static char temp[2048];
 	int sendmsg = rand() % 100;
 
-	if( (emulnet.currbuffsize >= ENBUFFSIZE) || (size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE) || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
+	if( (emulnet.currbuffsize >= ENBUFFSIZE) || (size > em->capacity) || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
+		pool->release((char *)em, sizeof(en_msg) + em->capacity);
 		return 0;
 	}
 
-	em = (en_msg *)malloc(sizeof(en_msg) + size);
 	em->size = size;
 
 	memcpy(&(em->from.addr), &(myaddr->addr), sizeof(em->from.addr));
 	memcpy(&(em->to.addr), &(toaddr->addr), sizeof(em->from.addr));
-	memcpy(em + 1, data, size);
-
-	emulnet.buff[emulnet.currbuffsize++] = em;
 
-	int src = *(int *)(myaddr->addr);
-	int time = par->getcurrtime();
-
-	assert(src <= MAX_NODES);
-	assert(time < MAX_TIME);
+	emulnet.inbox[inboxKey(toaddr)].push_back(em);
+	emulnet.currbuffsize++;
 
-	sent_msgs[src][time]++;
+	countMessage(myaddr)->sent++;
+	msgStats[*(int *)(myaddr->addr)].sent_total++;
+	msgStats[*(int *)(myaddr->addr)].sent_bytes += size;
 
 	#ifdef DEBUGLOG
-		sprintf(temp, "Sending 4+%d B msg type %d to %d.%d.%d.%d:%d ", size-4, *(int *)data, toaddr->addr[0], toaddr->addr[1], toaddr->addr[2], toaddr->addr[3], *(short *)&toaddr->addr[4]);
+		sprintf(temp, "Sending 4+%d B msg type %d to %d.%d.%d.%d:%d ", size-4, *(int *)buffer, toaddr->addr[0], toaddr->addr[1], toaddr->addr[2], toaddr->addr[3], *(short *)&toaddr->addr[4]);
 	#endif
 
 	return size;
 }
 
+/**
+ * FUNCTION NAME: ENsend
+ *
+ * DESCRIPTION: EmulNet send function
+ *
+ * RETURNS:
+ * size
+ */
+int EmulNet::ENsend(Address *myaddr, Address *toaddr, const char *data, int size) {
+	char *buffer = ENbuffer(size);
+
+	if ( buffer == NULL ) {
+		return 0;
+	}
+
+	memcpy(buffer, data, size);
+	return ENsendBuffer(myaddr, toaddr, buffer, size);
+}
+
 /**
  * FUNCTION NAME: ENsend
  *
@@ -126,11 +244,7 @@ int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
  * size
  */
 int EmulNet::ENsend(Address *myaddr, Address *toaddr, string data) {
-	char * str = (char *) malloc(data.length() * sizeof(char));
-	memcpy(str, data.c_str(), data.size());
-	int ret = this->ENsend(myaddr, toaddr, str, (data.length() * sizeof(char)));
-	free(str);
-	return ret;
+	return this->ENsend(myaddr, toaddr, data.data(), (data.length() * sizeof(char)));
 }
 
 /**
@@ -143,37 +257,76 @@ int EmulNet::ENsend(Address *myaddr, Address *toaddr, string data) {
  */
 int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue){
 	// times is always assumed to be 1
-	int i;
-	char* tmp;
-	int sz;
 	en_msg *emsg;
 
-	for( i = emulnet.currbuffsize - 1; i >= 0; i-- ) {
-		emsg = emulnet.buff[i];
+	unordered_map<unsigned long long, vector<en_msg *>>::iterator box = emulnet.inbox.find(inboxKey(myaddr));
+	if ( box == emulnet.inbox.end() || box->second.empty() ) {
+		return 0;
+	}
 
-		if ( 0 == strcmp(emsg->to.addr, myaddr->addr) ) {
-			sz = emsg->size;
-			tmp = (char *) malloc(sz * sizeof(char));
-			memcpy(tmp, (char *)(emsg+1), sz);
+	en_tick *tick = countMessage(myaddr);
+	en_counters &counters = msgStats[*(int *)(myaddr->addr)];
+	int received = box->second.size();
 
-			emulnet.buff[i] = emulnet.buff[emulnet.currbuffsize-1];
-			emulnet.currbuffsize--;
+	// Only messages addressed to this node are visited, in arrival order.
+	// The payload is handed over in place; the receiver gives it back through ENrelease
+	for ( vector<en_msg *>::iterator it = box->second.begin(); it != box->second.end(); ++it ) {
+		emsg = *it;
 
-			(*enq)(queue, (char *)tmp, sz);
+		counters.recv_bytes += emsg->size;
 
-			free(emsg);
+		(*enq)(queue, (char *)(emsg+1), emsg->size);
+	}
+	tick->recv += received;
+	counters.recv_total += received;
+	emulnet.currbuffsize -= received;
+	box->second.clear();
 
-			int dst = *(int *)(myaddr->addr);
-			int time = par->getcurrtime();
+	return 0;
+}
 
-			assert(dst <= MAX_NODES);
-			assert(time < MAX_TIME);
+/**
+ * FUNCTION NAME: ENrelease
+ *
+ * DESCRIPTION: Give a payload delivered by ENrecv back to the message pool
+ */
+void EmulNet::ENrelease(char *data) {
+	en_msg *emsg = (en_msg *)data - 1;
+	pool->release((char *)emsg, sizeof(en_msg) + emsg->capacity);
+}
 
-			recv_msgs[dst][time]++;
-		}
+/**
+ * FUNCTION NAME: ENdiscard
+ *
+ * DESCRIPTION: Drop the messages waiting for a node, as a node that crashed never reads them
+ */
+void EmulNet::ENdiscard(Address *myaddr) {
+	unordered_map<unsigned long long, vector<en_msg *>>::iterator box = emulnet.inbox.find(inboxKey(myaddr));
+	if ( box == emulnet.inbox.end() ) {
+		return;
 	}
 
-	return 0;
+	for ( vector<en_msg *>::iterator it = box->second.begin(); it != box->second.end(); ++it ) {
+		pool->release((char *)(*it), sizeof(en_msg) + (*it)->capacity);
+	}
+	emulnet.currbuffsize -= box->second.size();
+	box->second.clear();
+}
+
+/**
+ * FUNCTION NAME: ENcounters
+ *
+ * DESCRIPTION: Message counters of a node
+ *
+ * RETURNS:
+ * pointer to the counters, NULL if the node never sent nor received
+ */
+en_counters *EmulNet::ENcounters(Address *addr) {
+	int node = *(int *)(addr->addr);
+	if ( node < 0 || node >= (int) msgStats.size() ) {
+		return NULL;
+	}
+	return &msgStats[node];
 }
 
 /**
@@ -184,35 +337,46 @@ int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct ti
 int EmulNet::ENcleanup() {
 	emulnet.nextid=0;
 	int i, j;
-	int sent_total, recv_total;
+	int sent, recv;
 
 	FILE* file = fopen("msgcount.log", "w+");
 
-	while(emulnet.currbuffsize > 0) {
-		free(emulnet.buff[--emulnet.currbuffsize]);
+	for ( unordered_map<unsigned long long, vector<en_msg *>>::iterator box = emulnet.inbox.begin(); box != emulnet.inbox.end(); ++box ) {
+		for ( vector<en_msg *>::iterator it = box->second.begin(); it != box->second.end(); ++it ) {
+			pool->release((char *)*it, sizeof(en_msg) + (*it)->capacity);
+		}
 	}
+	emulnet.inbox.clear();
+	emulnet.currbuffsize = 0;
 
+	// Stream the sparse series out, filling the silent time units with zeros
+	en_counters none;
 	for ( i = 1; i <= par->EN_GPSZ; i++ ) {
+		en_counters &counters = i < (int) msgStats.size() ? msgStats[i] : none;
+		vector<en_tick>::iterator tick = counters.series.begin();
 		fprintf(file, "node %3d ", i);
-		sent_total = 0;
-		recv_total = 0;
 
 		for (j = 0; j < par->getcurrtime(); j++) {
+			sent = 0;
+			recv = 0;
+			if ( tick != counters.series.end() && tick->time == j ) {
+				sent = tick->sent;
+				recv = tick->recv;
+				++tick;
+			}
 
-			sent_total += sent_msgs[i][j];
-			recv_total += recv_msgs[i][j];
 			if (i != 67) {
-				fprintf(file, " (%4d, %4d)", sent_msgs[i][j], recv_msgs[i][j]);
+				fprintf(file, " (%4d, %4d)", sent, recv);
 				if (j % 10 == 9) {
 					fprintf(file, "\n         ");
 				}
 			}
 			else {
-				fprintf(file, "special %4d %4d %4d\n", j, sent_msgs[i][j], recv_msgs[i][j]);
+				fprintf(file, "special %4d %4d %4d\n", j, sent, recv);
 			}
 		}
 		fprintf(file, "\n");
-		fprintf(file, "node %3d sent_total %6u  recv_total %6u\n\n", i, sent_total, recv_total);
+		fprintf(file, "node %3d sent_total %6u  recv_total %6u  sent_bytes %9lu  recv_bytes %9lu\n\n", i, counters.sent_total, counters.recv_total, counters.sent_bytes, counters.recv_bytes);
 	}
 
 	fclose(file);
@@ -7,9 +7,9 @@
 #ifndef _EMULNET_H_
 #define _EMULNET_H_
 
-#define MAX_NODES 1000
-#define MAX_TIME 3600
 #define ENBUFFSIZE 30000
+#define ENPOOL_MIN_BLOCK 64
+#define ENPOOL_SLAB_BLOCKS 32
 
 #include "stdincludes.h"
 #include "Params.h"
@@ -23,12 +23,62 @@ using namespace std;
 typedef struct en_msg {
 	// Number of bytes after the class
 	int size;
+	// Number of bytes reserved after the class
+	int capacity;
 	// Source node
 	Address from;
 	// Destination node
 	Address to;
 }en_msg;
 
+/**
+ * Struct Name: en_tick
+ *
+ * DESCRIPTION: Messages sent and received by a node during one time unit
+ */
+typedef struct en_tick {
+	int time;
+	int sent;
+	int recv;
+}en_tick;
+
+/**
+ * Struct Name: en_counters
+ *
+ * DESCRIPTION: Message counters of a single node. Only the time units in which
+ * 				the node had traffic are recorded, in increasing time order.
+ */
+typedef struct en_counters {
+	int sent_total;
+	int recv_total;
+	unsigned long sent_bytes;
+	unsigned long recv_bytes;
+	vector<en_tick> series;
+	en_counters(): sent_total(0), recv_total(0), sent_bytes(0), recv_bytes(0) {}
+}en_counters;
+
+/**
+ * CLASS NAME: ENPool
+ *
+ * DESCRIPTION: Size-classed slab allocator for message blocks (en_msg + payload).
+ * 				Blocks are carved out of slabs of ENPOOL_SLAB_BLOCKS and recycled
+ * 				through a free list per power-of-two size class.
+ */
+class ENPool {
+private:
+	int maxBlockSize;
+	vector<char *> slabs;
+	vector<vector<char *>> freeBlocks;
+	ENPool(const ENPool &anotherPool);
+	ENPool& operator = (const ENPool &anotherPool);
+	int sizeClass(int blockSize);
+public:
+	ENPool(int maxBlockSize);
+	char *alloc(int blockSize);
+	void release(char *block, int blockSize);
+	virtual ~ENPool();
+};
+
 /**
  * Class Name: EM
  */
@@ -37,17 +87,14 @@ public:
 	int nextid;
 	int currbuffsize;
 	int firsteltindex;
-	en_msg* buff[ENBUFFSIZE];
+	// In-flight messages, bucketed by destination address
+	unordered_map<unsigned long long, vector<en_msg *>> inbox;
 	EM() {}
 	EM& operator = (EM &anotherEM) {
 		this->nextid = anotherEM.getNextId();
 		this->currbuffsize = anotherEM.getCurrBuffSize();
 		this->firsteltindex = anotherEM.getFirstEltIndex();
-		int i = this->currbuffsize;
-		while (i > 0) {
-			this->buff[i] = anotherEM.buff[i];
-			i--;
-		}
+		this->inbox = anotherEM.inbox;
 		return *this;
 	}
 	int getNextId() {
@@ -80,19 +127,29 @@ class EmulNet
 { 	
 private:
 	Params* par;
-	int sent_msgs[MAX_NODES + 1][MAX_TIME];
-	int recv_msgs[MAX_NODES + 1][MAX_TIME];
+	// Message counters indexed by node id, grown as nodes show up
+	vector<en_counters> msgStats;
 	int enInited;
 	EM emulnet;
+	ENPool *pool;
+	// In-flight messages live in pool, so a copy could not own them
+	EmulNet(const EmulNet &anotherEmulNet);
+	EmulNet& operator = (const EmulNet &anotherEmulNet);
+	static unsigned long long inboxKey(Address *addr);
+	en_tick *countMessage(Address *addr);
 public:
  	EmulNet(Params *p);
- 	EmulNet(EmulNet &anotherEmulNet);
- 	EmulNet& operator = (EmulNet &anotherEmulNet);
  	virtual ~EmulNet();
 	void *ENinit(Address *myaddr, short port);
 	int ENsend(Address *myaddr, Address *toaddr, string data);
-	int ENsend(Address *myaddr, Address *toaddr, char *data, int size);
+	int ENsend(Address *myaddr, Address *toaddr, const char *data, int size);
+	int ENmaxPayload();
+	char *ENbuffer(int size);
+	int ENsendBuffer(Address *myaddr, Address *toaddr, char *buffer, int size);
 	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue);
+	void ENrelease(char *data);
+	void ENdiscard(Address *myaddr);
+	en_counters *ENcounters(Address *addr);
 	int ENcleanup();
 };
 
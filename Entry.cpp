@@ -15,6 +15,18 @@ Entry::Entry(string _value, int _timestamp, ReplicaType _replica){
 	replica = _replica;
 }
 
+/**
+ * constructor
+ *
+ * DESCRIPTION: Copy a decoded entry
+ */
+Entry::Entry(const EntryView &view){
+	this->delimiter = ":";
+	value = view.value.toString();
+	timestamp = view.timestamp;
+	replica = view.replica;
+}
+
 /**
  * constructor
  *
@@ -46,3 +58,67 @@ Entry::Entry(string entry){
 string Entry::convertToString() {
 	return value + delimiter + to_string(timestamp) + delimiter + to_string(replica);
 }
+
+/**
+ * FUNCTION NAME: encode
+ *
+ * DESCRIPTION: Write the stored form of the entry into buffer, replacing its contents
+ */
+void Entry::encode(string &buffer) {
+	encode(value, timestamp, replica, buffer);
+}
+
+/**
+ * FUNCTION NAME: encode
+ *
+ * DESCRIPTION: Write the stored form of a value at a version into buffer, replacing its contents
+ */
+void Entry::encode(StringView value, int timestamp, ReplicaType replica, string &buffer) {
+	buffer.resize(ENTRY_HEADER_SIZE);
+	memcpy(&buffer[0], &timestamp, sizeof(int));
+	buffer[sizeof(int)] = (char) replica;
+	buffer.append(value.data(), value.size());
+}
+
+/**
+ * FUNCTION NAME: decode
+ *
+ * DESCRIPTION: Decode a stored entry in place. The value of the view points into data.
+ *
+ * RETURNS:
+ * false if data is too short to be an entry
+ */
+bool Entry::decode(StringView data, EntryView *view) {
+	if ( data.size() < ENTRY_HEADER_SIZE ) {
+		return false;
+	}
+	memcpy(&view->timestamp, data.data(), sizeof(int));
+	view->replica = static_cast<ReplicaType>(data.data()[sizeof(int)]);
+	view->value = StringView(data.data() + ENTRY_HEADER_SIZE, data.size() - ENTRY_HEADER_SIZE);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: fingerprint
+ *
+ * DESCRIPTION: Hash of a value, used to order versions written at the same timestamp.
+ * 				Always XXH64, whatever hash places keys on the ring.
+ */
+unsigned long long Entry::fingerprint(StringView value) {
+	return xxh64(value.data(), value.size(), 0);
+}
+
+/**
+ * FUNCTION NAME: supersedes
+ *
+ * DESCRIPTION: Whether a write of value at timestamp replaces the stored entry. The later
+ * 				timestamp wins; at equal timestamps the larger value fingerprint wins, so
+ * 				every replica keeps the same version whatever order the writes arrive in.
+ * 				Rewriting the stored version itself counts as replacing it.
+ */
+bool Entry::supersedes(int timestamp, StringView value, const EntryView &stored) {
+	if ( timestamp != stored.timestamp ) {
+		return timestamp > stored.timestamp;
+	}
+	return fingerprint(value) >= fingerprint(stored.value);
+}
@@ -4,8 +4,32 @@
  * DESCRIPTION: Header file Entry class
  **********************************/
 
+#ifndef ENTRY_H_
+#define ENTRY_H_
+
 #include "stdincludes.h"
 #include "Message.h"
+#include "StringView.h"
+#include "Hash.h"
+
+/**
+ * Stored form of an entry, as kept in the hash table:
+ * 		timestamp	4 bytes, version of the value
+ * 		replica		1 byte, ReplicaType
+ * 		value		the remaining bytes
+ */
+#define ENTRY_HEADER_SIZE 5
+
+/**
+ * STRUCT NAME: EntryView
+ *
+ * DESCRIPTION: Decoded entry whose value points into the hash table
+ */
+typedef struct EntryView {
+	StringView value;
+	int timestamp;
+	ReplicaType replica;
+}EntryView;
 
 /**
  * CLASS NAME: Entry
@@ -21,5 +45,15 @@ public:
 
 	Entry(string entry);
 	Entry(string _value, int _timestamp, ReplicaType _replica);
+	Entry(const EntryView &view);
 	string convertToString();
+	// stored form, written into a reusable buffer
+	void encode(string &buffer);
+	static void encode(StringView value, int timestamp, ReplicaType replica, string &buffer);
+	static bool decode(StringView data, EntryView *view);
+	// version order between a write and the stored entry
+	static unsigned long long fingerprint(StringView value);
+	static bool supersedes(int timestamp, StringView value, const EntryView &stored);
 };
+
+#endif /* ENTRY_H_ */
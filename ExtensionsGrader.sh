@@ -0,0 +1,214 @@
+#**********************
+#*
+#* Progam Name: MP1/MP2. Membership Protocol and Key-Value Store.
+#*
+#* Current file: ExtensionsGrader.sh
+#* About this file: Test script for the features beyond the assignment
+#* 				(failure detectors, gossip fan-out and period, delta gossip, batched
+#* 				key-value operations, stabilization digests, write-ahead log recovery).
+#*
+#***********************
+#!/bin/bash
+
+function contains () {
+  	local e
+  	for e in "${@:2}"
+	do
+		if [ "$e" == "$1" ]; then
+			echo 1
+			return 1;
+		fi
+	done
+  	echo 0
+}
+
+# Run a test case, quietly unless -v was given
+function run () {
+	if [ $verbose -eq 0 ]; then
+		./Application $1 > /dev/null
+	else
+		./Application $1
+	fi
+}
+
+# Record the outcome of a check: check <name> <0 if passed>
+function check () {
+	total=`expr $total + 1`
+	if [ $2 -eq 0 ]; then
+		passed=`expr $passed + 1`
+		echo "Checking $1..........PASS"
+	else
+		echo "Checking $1..........FAIL"
+	fi
+}
+
+# Check the removals in dbg.log against the failures: every failed node is removed by all the
+# nodes still alive (completeness), and no node that is alive is removed (accuracy)
+function detectorChecks () {
+	failednodes=`grep "Node failed at time" dbg.log | sort -u | awk '{print $1}' | tr '\n' '|' | sed 's/|$//'`
+	falseremovals=`grep removed dbg.log | grep -v -E "Node ($failednodes) removed" | wc -l`
+	nodes=`grep MAX_NNB testcases/$1.conf | awk '{print $2}'`
+	alive=`expr $nodes - \`echo $failednodes | tr '|' '\n' | wc -l\``
+	missed=0
+	for i in `echo $failednodes | tr '|' ' '`
+	do
+		removers=`grep removed dbg.log | grep "Node $i removed" | awk '{print $1}' | sort -u | grep -v -E "^($failednodes)$" | wc -l`
+		if [ $removers -lt $alive ]; then
+			missed=`expr $missed + 1`
+		fi
+	done
+	check "$1 Completeness" $missed
+	check "$1 Accuracy (false removals: $falseremovals)" $falseremovals
+}
+
+verbose=$(contains "-v" "$@")
+passed=0
+total=0
+
+if [ $verbose -eq 0 ]; then
+	make clean > /dev/null
+	make > /dev/null
+else
+	make clean
+	make
+fi
+
+echo "============================================"
+echo "SWIM Message Drop Scenarios"
+echo "============================"
+# The runs are seeded from the clock, so each one waits for a new second
+for conf in swimmsgdrop swimmsgdrop swimmsgdrop swimmsgdropmultifailure swimmsgdropmultifailure
+do
+	sleep 1
+	run testcases/$conf.conf
+	detectorChecks $conf
+done
+
+echo "============================================"
+echo "Phi-Accrual Message Drop Scenarios"
+echo "============================"
+for conf in phimsgdrop phimsgdrop phimsgdrop phimsgdropmultifailure phimsgdropmultifailure
+do
+	sleep 1
+	run testcases/$conf.conf
+	detectorChecks $conf
+done
+
+echo "============================================"
+echo "Gossip Fan-out and Period"
+echo "============================"
+# Half the nodes fail; each node gossips to 3 of the 9 others, every other time unit
+for conf in gossipfanout gossipfanout gossipfanout
+do
+	sleep 1
+	run testcases/$conf.conf
+	detectorChecks $conf
+done
+
+echo "============================================"
+echo "Delta Gossip"
+echo "============================"
+# The same scenario gossiped in full, then with only the changed entries and a full list
+# every GOSSIP_FULL_SYNC rounds
+sleep 1
+run testcases/msgdropsinglefailure.conf
+fullbytes=`grep "membership sent_bytes" stats.log | awk '{sum += $6} END {print sum}'`
+sleep 1
+run testcases/deltagossip.conf
+deltabytes=`grep "membership sent_bytes" stats.log | awk '{sum += $6} END {print sum}'`
+converged=`grep "membership converged" stats.log | awk '{print $8}'`
+check "deltagossip Convergence (at time $converged)" `[ $converged -ge 0 ]; echo $?`
+detectorChecks deltagossip
+check "deltagossip sends at most half the bytes of full gossip ($deltabytes / $fullbytes)" `[ \`expr $deltabytes \* 2\` -le $fullbytes ]; echo $?`
+
+echo "============================================"
+echo "Batched Key-Value Operations"
+echo "============================"
+run testcases/batch.conf
+# Every key read by multiGet is read at least in quorum of replicas, plus the coordinator
+failed=0
+for key in `grep "READ OPERATION" dbg.log | cut -d" " -f7`
+do
+	value=`grep "READ OPERATION KEY: $key " dbg.log | cut -d" " -f9`
+	if [ `grep "read success" dbg.log | grep "key=$key, value=$value$" | wc -l` -lt 3 ]; then
+		failed=`expr $failed + 1`
+	fi
+done
+check "multiGet (keys below quorum: $failed)" $failed
+# Every key created, by clientCreate or multiPut, is created at all replicas and the coordinator
+failed=0
+for key in `grep "CREATE OPERATION" dbg.log | cut -d" " -f7`
+do
+	if [ `grep "create success" dbg.log | grep "key=$key, " | wc -l` -ne 4 ]; then
+		failed=`expr $failed + 1`
+	fi
+done
+check "multiPut (keys not created: $failed)" $failed
+# Every valid key deleted by multiDelete is deleted at all replicas, and the invalid key fails
+failed=0
+for key in `grep "DELETE OPERATION" dbg.log | cut -d" " -f7 | grep -v invalidKey`
+do
+	if [ `grep "delete success" dbg.log | grep "key=$key$" | wc -l` -ne 4 ]; then
+		failed=`expr $failed + 1`
+	fi
+done
+if [ `grep "coordinator: delete fail" dbg.log | grep "key=invalidKey$" | wc -l` -ne 1 ]; then
+	failed=`expr $failed + 1`
+fi
+check "multiDelete (keys mishandled: $failed)" $failed
+
+echo "============================================"
+echo "Stabilization Digests of Large Values"
+echo "============================"
+# Values of VALUE_SIZE bytes are re-replicated as a DIGEST that the new replica PULLs
+sleep 1
+run testcases/readlarge.conf
+size=`grep VALUE_SIZE testcases/readlarge.conf | awk '{print $2}'`
+value=`grep "READ OPERATION" dbg.log | grep -v invalidKey | head -1 | cut -d" " -f9`
+reads=`grep "coordinator: read success" dbg.log | grep "value=$value$" | wc -l`
+if [ ${#value} -ne $size -o $reads -ne 4 ]; then
+	failed=1
+else
+	failed=0
+fi
+check "Large value read in full (reads: $reads / 4)" $failed
+pulled=`grep "server: create success" dbg.log | grep "transID=-1," | wc -l`
+cut=`grep "server: create success" dbg.log | grep "transID=-1," | sed 's/.*value=//' | awk -v size=$size 'length($0) != size' | wc -l`
+if [ $pulled -eq 0 -o $cut -ne 0 ]; then
+	failed=1
+else
+	failed=0
+fi
+check "Pulled replicas (pulled: $pulled, cut short: $cut)" $failed
+
+echo "============================================"
+echo "Write-Ahead Log Recovery"
+echo "============================"
+# A node is failed and restarted; its large values would come back from its peers as digest pulls.
+# The second run finds the logs of the first, which must not be replayed
+for conf in restart restart restartnowal
+do
+	sleep 1
+	run testcases/$conf.conf
+	node=`grep "Node restarted" dbg.log | awk '{print $1}'`
+	failtime=`grep "^ $node .*Node failed" dbg.log | awk '{print $2}' | tr -d '[]'`
+	restarttime=`grep "Node restarted" dbg.log | awk '{print $2}' | tr -d '[]'`
+	held=`grep "^ $node .*server: create success" dbg.log | awk -v t=$failtime '{gsub(/[][]/, "", $2)} $2 < t' | sed 's/.*key=//' | cut -d, -f1 | sort -u | wc -l`
+	recovered=`grep "^ $node .*Recovered" dbg.log | awk '{print $4}'`
+	pulled=`grep "^ $node .*server: create success" dbg.log | grep "transID=-1," | awk -v t=$restarttime '{gsub(/[][]/, "", $2)} $2 >= t' | wc -l`
+	reads=`grep "READ OPERATION" dbg.log | wc -l`
+	readsuccess=`grep "coordinator: read success" dbg.log | wc -l`
+	if [ $conf == "restart" ]; then
+		check "Restarted node recovered its keys locally (recovered: ${recovered:-0} / $held)" `[ "$recovered" == "$held" -a $held -gt 0 ]; echo $?`
+		check "Restarted node pulled none of them (pulled: $pulled)" $pulled
+	else
+		check "Without the log the keys are pulled back (pulled: $pulled / $held)" `[ $pulled -eq $held -a -z "$recovered" ]; echo $?`
+	fi
+	check "$conf reads after the restart ($readsuccess / $reads)" `[ $readsuccess -eq $reads ]; echo $?`
+done
+
+echo "============================================"
+echo "Passed $passed / $total"
+if [ $passed -ne $total ]; then
+	exit 1
+fi
@@ -0,0 +1,441 @@
+/**********************************
+ * FILE NAME: FlatHashMap.cpp
+ *
+ * DESCRIPTION: FlatHashMap class definition
+ **********************************/
+
+#include "FlatHashMap.h"
+#include "Hash.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Control bytes of free slots have the sign bit set; full slots hold 7 bits of the key hash
+#define CTRL_EMPTY ((signed char) -128)
+#define CTRL_DELETED ((signed char) -2)
+// Length byte of a key or value kept in the arena
+#define STORED_IN_ARENA 0xFF
+
+/**
+ * FUNCTION NAME: matchByte
+ *
+ * DESCRIPTION: Compare the control bytes of a group against a byte
+ *
+ * RETURNS:
+ * a bit mask with bit i set if byte i of the group matches
+ */
+static unsigned int matchByte(const signed char *group, signed char byte) {
+#ifdef __SSE2__
+	__m128i bytes = _mm_loadu_si128((const __m128i *) group);
+	return (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(byte)));
+#else
+	unsigned int bits = 0;
+	for ( int i = 0; i < FLAT_GROUP_SIZE; i++ ) {
+		if ( group[i] == byte ) {
+			bits |= 1u << i;
+		}
+	}
+	return bits;
+#endif
+}
+
+/**
+ * FUNCTION NAME: matchFree
+ *
+ * DESCRIPTION: Find the empty or deleted slots of a group
+ *
+ * RETURNS:
+ * a bit mask with bit i set if slot i of the group is free
+ */
+static unsigned int matchFree(const signed char *group) {
+#ifdef __SSE2__
+	return (unsigned int) _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) group));
+#else
+	unsigned int bits = 0;
+	for ( int i = 0; i < FLAT_GROUP_SIZE; i++ ) {
+		if ( group[i] < 0 ) {
+			bits |= 1u << i;
+		}
+	}
+	return bits;
+#endif
+}
+
+FlatHashMap::FlatHashMap(unsigned long initialCapacity) {
+	capacity = FLAT_GROUP_SIZE;
+	while ( capacity < initialCapacity ) {
+		capacity <<= 1;
+	}
+	ctrl.assign(capacity + FLAT_GROUP_SIZE, CTRL_EMPTY);
+	slots.resize(capacity);
+	garbage = 0;
+	used = 0;
+	deleted = 0;
+}
+
+FlatHashMap::~FlatHashMap() {}
+
+/**
+ * FUNCTION NAME: hash
+ *
+ * DESCRIPTION: Hash a key; the high bits pick the first group probed, the low 7 bits go in the control byte
+ */
+unsigned long long FlatHashMap::hash(StringView key) {
+	return xxh64(key.data(), key.size(), 0);
+}
+
+/**
+ * FUNCTION NAME: setCtrl
+ *
+ * DESCRIPTION: Set the control byte of a slot, keeping the copy of the first group in sync
+ */
+void FlatHashMap::setCtrl(unsigned long index, signed char value) {
+	ctrl[index] = value;
+	if ( index < FLAT_GROUP_SIZE ) {
+		ctrl[capacity + index] = value;
+	}
+}
+
+/**
+ * FUNCTION NAME: findIndex
+ *
+ * DESCRIPTION: Probe the groups of a key, in triangular steps, until the key or an empty slot shows up.
+ * 				If freeIndex is given, it receives the first free slot passed on the way, where
+ * 				the key would be inserted.
+ *
+ * RETURNS:
+ * the slot of the key if found
+ * -1 otherwise
+ */
+long FlatHashMap::findIndex(StringView key, unsigned long long keyHash, long *freeIndex) const {
+	unsigned long mask = capacity - 1;
+	signed char fingerprint = (signed char) (keyHash & 0x7F);
+	unsigned long pos = (keyHash >> 7) & mask;
+
+	if ( freeIndex != NULL ) {
+		*freeIndex = -1;
+	}
+
+	for ( unsigned long step = FLAT_GROUP_SIZE; ; step += FLAT_GROUP_SIZE ) {
+		const signed char *group = &ctrl[pos];
+
+		for ( unsigned int bits = matchByte(group, fingerprint); bits != 0; bits &= bits - 1 ) {
+			unsigned long index = (pos + __builtin_ctz(bits)) & mask;
+			if ( view(slots[index].key) == key ) {
+				return index;
+			}
+		}
+		if ( freeIndex != NULL && *freeIndex < 0 ) {
+			unsigned int bits = matchFree(group);
+			if ( bits != 0 ) {
+				*freeIndex = (pos + __builtin_ctz(bits)) & mask;
+			}
+		}
+		if ( matchByte(group, CTRL_EMPTY) != 0 ) {
+			return -1;
+		}
+		pos = (pos + step) & mask;
+	}
+}
+
+/**
+ * FUNCTION NAME: findFree
+ *
+ * DESCRIPTION: First empty or deleted slot on the probe sequence of a hash
+ */
+unsigned long FlatHashMap::findFree(unsigned long long keyHash) const {
+	unsigned long mask = capacity - 1;
+	unsigned long pos = (keyHash >> 7) & mask;
+
+	for ( unsigned long step = FLAT_GROUP_SIZE; ; step += FLAT_GROUP_SIZE ) {
+		unsigned int bits = matchFree(&ctrl[pos]);
+		if ( bits != 0 ) {
+			return (pos + __builtin_ctz(bits)) & mask;
+		}
+		pos = (pos + step) & mask;
+	}
+}
+
+/**
+ * FUNCTION NAME: rehash
+ *
+ * DESCRIPTION: Move every entry into a table of newCapacity slots, dropping deleted slots
+ */
+void FlatHashMap::rehash(unsigned long newCapacity) {
+	vector<signed char> oldCtrl;
+	vector<Slot> oldSlots;
+	unsigned long oldCapacity = capacity;
+
+	oldCtrl.swap(ctrl);
+	oldSlots.swap(slots);
+	capacity = newCapacity;
+	ctrl.assign(capacity + FLAT_GROUP_SIZE, CTRL_EMPTY);
+	slots.resize(capacity);
+	used = 0;
+	deleted = 0;
+
+	for ( unsigned long i = 0; i < oldCapacity; i++ ) {
+		if ( oldCtrl[i] < 0 ) {
+			continue;
+		}
+		unsigned long index = findFree(hash(view(oldSlots[i].key)));
+		setCtrl(index, oldCtrl[i]);
+		slots[index] = oldSlots[i];
+		used++;
+	}
+}
+
+/**
+ * FUNCTION NAME: view
+ *
+ * DESCRIPTION: The bytes of a stored key or value, wherever they live
+ */
+StringView FlatHashMap::view(const Stored &stored) const {
+	unsigned int offset;
+	unsigned int length;
+
+	if ( stored.length != STORED_IN_ARENA ) {
+		return StringView(stored.bytes, stored.length);
+	}
+	memcpy(&offset, stored.bytes, sizeof(unsigned int));
+	memcpy(&length, stored.bytes + sizeof(unsigned int), sizeof(unsigned int));
+	return StringView(&arena[offset], length);
+}
+
+/**
+ * FUNCTION NAME: store
+ *
+ * DESCRIPTION: Keep a copy of data inline if it fits, else at the end of the arena.
+ * 				data must not point into this map.
+ */
+void FlatHashMap::store(Stored &stored, StringView data) {
+	unsigned int offset = arena.size();
+	unsigned int length = data.size();
+
+	if ( length <= FLAT_INLINE_SIZE ) {
+		memcpy(stored.bytes, data.data(), length);
+		stored.length = length;
+		return;
+	}
+	arena.insert(arena.end(), data.data(), data.data() + length);
+	memcpy(stored.bytes, &offset, sizeof(unsigned int));
+	memcpy(stored.bytes + sizeof(unsigned int), &length, sizeof(unsigned int));
+	stored.length = STORED_IN_ARENA;
+}
+
+/**
+ * FUNCTION NAME: release
+ *
+ * DESCRIPTION: Drop a stored key or value, counting its arena bytes as garbage
+ */
+void FlatHashMap::release(Stored &stored) {
+	if ( stored.length == STORED_IN_ARENA ) {
+		garbage += view(stored).size();
+	}
+	stored.length = 0;
+}
+
+/**
+ * FUNCTION NAME: compact
+ *
+ * DESCRIPTION: Once the arena holds more garbage than live bytes, copy the live keys and
+ * 				values into a fresh arena
+ */
+void FlatHashMap::compact() {
+	if ( garbage < FLAT_COMPACT_MIN_GARBAGE || garbage * 2 < arena.size() ) {
+		return;
+	}
+
+	vector<char> oldArena;
+	oldArena.swap(arena);
+	arena.reserve(oldArena.size() - garbage);
+	garbage = 0;
+
+	for ( unsigned long i = 0; i < capacity; i++ ) {
+		if ( ctrl[i] < 0 ) {
+			continue;
+		}
+		Stored *parts[2] = { &slots[i].key, &slots[i].value };
+		for ( int part = 0; part < 2; part++ ) {
+			unsigned int offset;
+			unsigned int length;
+			if ( parts[part]->length != STORED_IN_ARENA ) {
+				continue;
+			}
+			memcpy(&offset, parts[part]->bytes, sizeof(unsigned int));
+			memcpy(&length, parts[part]->bytes + sizeof(unsigned int), sizeof(unsigned int));
+			store(*parts[part], StringView(&oldArena[offset], length));
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: Look up a key
+ *
+ * RETURNS:
+ * the slot of the key if found
+ * -1 otherwise
+ */
+long FlatHashMap::find(StringView key) const {
+	return findIndex(key, hash(key));
+}
+
+/**
+ * FUNCTION NAME: findOrInsert
+ *
+ * DESCRIPTION: Look up a key, adding it with an empty value if it is missing, in a single probe.
+ * 				Once live and deleted slots pass 7/8 of the table it is rebuilt, twice as large
+ * 				if more than half the slots are live.
+ *
+ * RETURNS:
+ * the slot of the key, valid until the next insertion; inserted tells whether it is new
+ */
+long FlatHashMap::findOrInsert(StringView key, bool *inserted) {
+	unsigned long long keyHash = hash(key);
+	long index;
+	long freeIndex;
+
+	index = findIndex(key, keyHash, &freeIndex);
+	if ( index >= 0 ) {
+		*inserted = false;
+		return index;
+	}
+
+	if ( (used + deleted + 1) * 8 > capacity * 7 ) {
+		rehash((used + 1) * 2 > capacity ? capacity * 2 : capacity);
+		freeIndex = findFree(keyHash);
+	}
+	if ( ctrl[freeIndex] == CTRL_DELETED ) {
+		deleted--;
+	}
+	setCtrl(freeIndex, (signed char) (keyHash & 0x7F));
+	store(slots[freeIndex].key, key);
+	slots[freeIndex].value.length = 0;
+	used++;
+
+	*inserted = true;
+	return freeIndex;
+}
+
+/**
+ * FUNCTION NAME: insert
+ *
+ * DESCRIPTION: Add a key that is not in the map yet
+ *
+ * RETURNS:
+ * false if the key was already present, in which case its value is kept
+ */
+bool FlatHashMap::insert(StringView key, StringView value) {
+	bool inserted;
+	long index = findOrInsert(key, &inserted);
+
+	if ( inserted ) {
+		store(slots[index].value, value);
+	}
+	return inserted;
+}
+
+StringView FlatHashMap::key(long index) const {
+	return view(slots[index].key);
+}
+
+StringView FlatHashMap::value(long index) const {
+	return view(slots[index].value);
+}
+
+/**
+ * FUNCTION NAME: setValue
+ *
+ * DESCRIPTION: Replace the value of the key in a slot. value must not point into this map.
+ */
+void FlatHashMap::setValue(long index, StringView value) {
+	release(slots[index].value);
+	store(slots[index].value, value);
+	compact();
+}
+
+/**
+ * FUNCTION NAME: erase
+ *
+ * DESCRIPTION: Remove a key, leaving a deleted marker so later probes go past its slot
+ *
+ * RETURNS:
+ * false if the key was not present
+ */
+bool FlatHashMap::erase(StringView key) {
+	long index = find(key);
+	if ( index < 0 ) {
+		return false;
+	}
+	erase(index);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: erase
+ *
+ * DESCRIPTION: Remove the entry in a slot returned by find or findOrInsert, without probing again
+ */
+void FlatHashMap::erase(long index) {
+	setCtrl(index, CTRL_DELETED);
+	release(slots[index].key);
+	release(slots[index].value);
+	used--;
+	deleted++;
+	compact();
+}
+
+unsigned long FlatHashMap::size() const {
+	return used;
+}
+
+bool FlatHashMap::empty() const {
+	return used == 0;
+}
+
+void FlatHashMap::clear() {
+	ctrl.assign(capacity + FLAT_GROUP_SIZE, CTRL_EMPTY);
+	arena.clear();
+	garbage = 0;
+	used = 0;
+	deleted = 0;
+}
+
+FlatHashMap::iterator FlatHashMap::begin() const {
+	return iterator(this, 0);
+}
+
+FlatHashMap::iterator FlatHashMap::end() const {
+	return iterator(this, capacity);
+}
+
+FlatHashMap::iterator::iterator(const FlatHashMap *table, unsigned long index): table(table), index(index) {
+	skipFree();
+}
+
+void FlatHashMap::iterator::skipFree() {
+	while ( index < table->capacity && table->ctrl[index] < 0 ) {
+		index++;
+	}
+}
+
+FlatHashMap::value_type FlatHashMap::iterator::operator *() const {
+	return value_type(table->key(index), table->value(index));
+}
+
+FlatHashMap::iterator &FlatHashMap::iterator::operator ++() {
+	index++;
+	skipFree();
+	return *this;
+}
+
+bool FlatHashMap::iterator::operator ==(const iterator &another) const {
+	return table == another.table && index == another.index;
+}
+
+bool FlatHashMap::iterator::operator !=(const iterator &another) const {
+	return !(*this == another);
+}
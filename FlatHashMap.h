@@ -0,0 +1,109 @@
+/**********************************
+ * FILE NAME: FlatHashMap.h
+ *
+ * DESCRIPTION: Header file FlatHashMap class
+ **********************************/
+
+#ifndef FLATHASHMAP_H_
+#define FLATHASHMAP_H_
+
+/**
+ * Header files
+ */
+#include "stdincludes.h"
+#include "StringView.h"
+
+/**
+ * Macros
+ */
+// Control bytes probed at once, one SSE2 register
+#define FLAT_GROUP_SIZE 16
+// Longest key or value kept inside its slot instead of the arena
+#define FLAT_INLINE_SIZE 15
+// Arena bytes left behind by deletes and overwrites before a compaction is considered
+#define FLAT_COMPACT_MIN_GARBAGE 4096
+
+/**
+ * CLASS NAME: FlatHashMap
+ *
+ * DESCRIPTION: Open-addressing map from strings to strings, laid out SwissTable style.
+ * 				A control byte per slot holds 7 bits of the key hash, or marks the slot
+ * 				empty or deleted, so a probe compares a whole group of control bytes at
+ * 				once (with SSE2 where available) and only touches the keys whose hash
+ * 				bits match. Lookups take a StringView, so callers holding a view never
+ * 				build a string to search.
+ *
+ * 				Entries are addressed by their slot index. A slot keeps keys and values of
+ * 				up to FLAT_INLINE_SIZE bytes inline; longer ones are appended to a single
+ * 				arena, which is compacted once deletes and overwrites have left more garbage
+ * 				than live bytes in it. Views of keys and values stay valid until the map is
+ * 				next modified.
+ */
+class FlatHashMap {
+public:
+	typedef pair<StringView, StringView> value_type;
+
+	/**
+	 * CLASS NAME: iterator
+	 *
+	 * DESCRIPTION: Walks the full slots in table order, yielding (key, value) views
+	 */
+	class iterator {
+	private:
+		const FlatHashMap *table;
+		unsigned long index;
+		void skipFree();
+	public:
+		iterator(const FlatHashMap *table, unsigned long index);
+		value_type operator *() const;
+		iterator &operator ++();
+		bool operator ==(const iterator &another) const;
+		bool operator !=(const iterator &another) const;
+	};
+
+private:
+	// A key or value: its bytes inline when length is at most FLAT_INLINE_SIZE, else its arena offset and length
+	struct Stored {
+		char bytes[FLAT_INLINE_SIZE];
+		unsigned char length;
+	};
+	struct Slot {
+		Stored key;
+		Stored value;
+	};
+	// One control byte per slot, followed by a copy of the first group so probes never wrap
+	vector<signed char> ctrl;
+	vector<Slot> slots;
+	vector<char> arena;
+	unsigned long garbage;
+	unsigned long capacity;
+	unsigned long used;
+	unsigned long deleted;
+	static unsigned long long hash(StringView key);
+	void setCtrl(unsigned long index, signed char value);
+	long findIndex(StringView key, unsigned long long keyHash, long *freeIndex = NULL) const;
+	unsigned long findFree(unsigned long long keyHash) const;
+	void rehash(unsigned long newCapacity);
+	StringView view(const Stored &stored) const;
+	void store(Stored &stored, StringView data);
+	void release(Stored &stored);
+	void compact();
+public:
+	FlatHashMap(unsigned long initialCapacity = FLAT_GROUP_SIZE);
+	long find(StringView key) const;
+	long findOrInsert(StringView key, bool *inserted);
+	bool insert(StringView key, StringView value);
+	StringView key(long index) const;
+	StringView value(long index) const;
+	void setValue(long index, StringView value);
+	bool erase(StringView key);
+	void erase(long index);
+	unsigned long size() const;
+	bool empty() const;
+	void clear();
+	iterator begin() const;
+	iterator end() const;
+	virtual ~FlatHashMap();
+};
+
+#endif /* FLATHASHMAP_H_ */
@@ -0,0 +1,148 @@
+/**********************************
+ * FILE NAME: Hash.cpp
+ *
+ * DESCRIPTION: Hash functions placing keys and nodes on the ring
+ **********************************/
+
+#include "Hash.h"
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+#define XXH_PRIME1 11400714785074694791ULL
+#define XXH_PRIME2 14029467366897019727ULL
+#define XXH_PRIME3 1609587929392839161ULL
+#define XXH_PRIME4 9650029242287828579ULL
+#define XXH_PRIME5 2870177450012600261ULL
+
+// Hash function selected for the ring, the same for every node of the run
+static int ringHashType = XXH64_HASH;
+
+/**
+ * FUNCTION NAME: setRingHash
+ *
+ * DESCRIPTION: Select the hash function used by ringHash
+ */
+void setRingHash(int hashType) {
+	ringHashType = hashType;
+}
+
+/**
+ * FUNCTION NAME: ringHash
+ *
+ * DESCRIPTION: Position of the given bytes on the 64-bit ring
+ */
+unsigned long long ringHash(const char *data, size_t length) {
+	switch ( ringHashType ) {
+		case STD_HASH:
+			return std::hash<string>()(string(data, length));
+		case FNV1A_HASH:
+			return fnv1a64(data, length);
+		default:
+			return xxh64(data, length, 0);
+	}
+}
+
+/**
+ * FUNCTION NAME: fnv1a64
+ *
+ * DESCRIPTION: 64-bit FNV-1a, one multiply per byte
+ */
+unsigned long long fnv1a64(const char *data, size_t length) {
+	unsigned long long hash = FNV_OFFSET;
+
+	for ( size_t i = 0; i < length; i++ ) {
+		hash ^= (unsigned char) data[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+static inline unsigned long long rotl64(unsigned long long x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline unsigned long long read64(const char *p) {
+	unsigned long long v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline unsigned int read32(const char *p) {
+	unsigned int v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline unsigned long long xxhRound(unsigned long long acc, unsigned long long input) {
+	acc += input * XXH_PRIME2;
+	acc = rotl64(acc, 31);
+	return acc * XXH_PRIME1;
+}
+
+static inline unsigned long long xxhMerge(unsigned long long acc, unsigned long long val) {
+	acc ^= xxhRound(0, val);
+	return acc * XXH_PRIME1 + XXH_PRIME4;
+}
+
+/**
+ * FUNCTION NAME: xxh64
+ *
+ * DESCRIPTION: XXH64 of the given bytes (little-endian reads, as on the hosts this runs on).
+ * 				Inputs of 32 bytes or more go through four independent accumulators.
+ */
+unsigned long long xxh64(const char *data, size_t length, unsigned long long seed) {
+	const char *p = data;
+	const char *end = data + length;
+	unsigned long long h;
+
+	if ( length >= 32 ) {
+		unsigned long long v1 = seed + XXH_PRIME1 + XXH_PRIME2;
+		unsigned long long v2 = seed + XXH_PRIME2;
+		unsigned long long v3 = seed;
+		unsigned long long v4 = seed - XXH_PRIME1;
+		const char *limit = end - 32;
+
+		do {
+			v1 = xxhRound(v1, read64(p));
+			v2 = xxhRound(v2, read64(p + 8));
+			v3 = xxhRound(v3, read64(p + 16));
+			v4 = xxhRound(v4, read64(p + 24));
+			p += 32;
+		} while ( p <= limit );
+
+		h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+		h = xxhMerge(h, v1);
+		h = xxhMerge(h, v2);
+		h = xxhMerge(h, v3);
+		h = xxhMerge(h, v4);
+	}
+	else {
+		h = seed + XXH_PRIME5;
+	}
+
+	h += length;
+
+	while ( p + 8 <= end ) {
+		h ^= xxhRound(0, read64(p));
+		h = rotl64(h, 27) * XXH_PRIME1 + XXH_PRIME4;
+		p += 8;
+	}
+	if ( p + 4 <= end ) {
+		h ^= (unsigned long long) read32(p) * XXH_PRIME1;
+		h = rotl64(h, 23) * XXH_PRIME2 + XXH_PRIME3;
+		p += 4;
+	}
+	while ( p < end ) {
+		h ^= (unsigned char) *p * XXH_PRIME5;
+		h = rotl64(h, 11) * XXH_PRIME1;
+		p++;
+	}
+
+	h ^= h >> 33;
+	h *= XXH_PRIME2;
+	h ^= h >> 29;
+	h *= XXH_PRIME3;
+	h ^= h >> 32;
+	return h;
+}
@@ -0,0 +1,28 @@
+/**********************************
+ * FILE NAME: Hash.h
+ *
+ * DESCRIPTION: Hash functions placing keys and nodes on the ring
+ **********************************/
+
+#ifndef HASH_H_
+#define HASH_H_
+
+/**
+ * Header files
+ */
+#include "stdincludes.h"
+
+/**
+ * Hash functions available for the ring
+ */
+enum hashTYPE { STD_HASH, FNV1A_HASH, XXH64_HASH };
+
+/**
+ * Ring positions span the whole 64-bit space
+ */
+unsigned long long ringHash(const char *data, size_t length);
+void setRingHash(int hashType);
+unsigned long long fnv1a64(const char *data, size_t length);
+unsigned long long xxh64(const char *data, size_t length, unsigned long long seed);
+
+#endif /* HASH_H_ */
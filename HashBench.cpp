@@ -0,0 +1,139 @@
+/**********************************
+ * FILE NAME: HashBench.cpp
+ *
+ * DESCRIPTION: Microbenchmark of the ring hash functions: hashing throughput,
+ * 				and how evenly each one spreads the ring among the nodes
+ **********************************/
+
+#include "stdincludes.h"
+#include "Hash.h"
+#include "Node.h"
+
+#define BENCH_BYTES (64 * 1024 * 1024)
+#define LEGACY_RING_SIZE 512
+
+static const char *hashNames[] = { "STD", "FNV", "XXH64" };
+
+// Keeps the hash results alive so the loops are not optimized away
+static volatile unsigned long long sink;
+
+/**
+ * FUNCTION NAME: benchThroughput
+ *
+ * DESCRIPTION: Hash BENCH_BYTES worth of random inputs of the given length with the
+ * 				selected ring hash, and print the rate
+ */
+void benchThroughput(int hashType, int length) {
+	int inputs = 1024;
+	vector<string> data(inputs);
+	for ( int i = 0; i < inputs; i++ ) {
+		data[i].resize(length);
+		for ( int j = 0; j < length; j++ ) {
+			data[i][j] = 'a' + rand() % 26;
+		}
+	}
+
+	setRingHash(hashType);
+	long hashes = BENCH_BYTES / length;
+	unsigned long long acc = 0;
+	auto start = std::chrono::steady_clock::now();
+	for ( long i = 0; i < hashes; i++ ) {
+		const string &input = data[i % inputs];
+		acc ^= ringHash(input.data(), input.size());
+	}
+	auto stop = std::chrono::steady_clock::now();
+	sink = acc;
+
+	double seconds = std::chrono::duration<double>(stop - start).count();
+	printf("%-6s %8d %12.1f %12.2f\n", hashNames[hashType], length,
+			hashes / seconds / 1e6, (double) hashes * length / seconds / (1024 * 1024));
+}
+
+/**
+ * FUNCTION NAME: benchBalance
+ *
+ * DESCRIPTION: Place nodeCount nodes with vnodes tokens each on the ring, as MP2Node does,
+ * 				and print how unevenly the ring is owned. A token owns the arc from the
+ * 				previous token up to itself. Also counts the tokens that would have
+ * 				shared a position on the former 512-slot ring.
+ */
+void benchBalance(int hashType, int nodeCount, int vnodes) {
+	vector<pair<unsigned long long, int>> tokens;
+
+	setRingHash(hashType);
+	for ( int i = 0; i < nodeCount; i++ ) {
+		Address address;
+		int id = i + 1;
+		short port = 0;
+		memcpy(&address.addr[0], &id, sizeof(int));
+		memcpy(&address.addr[4], &port, sizeof(short));
+		Node node(address);
+		for ( int token = 0; token < vnodes; token++ ) {
+			tokens.emplace_back(node.getTokenHashCode(token), i);
+		}
+	}
+	sort(tokens.begin(), tokens.end());
+
+	vector<double> share(nodeCount, 0);
+	vector<bool> slotUsed(LEGACY_RING_SIZE, false);
+	int legacyCollisions = 0;
+	for ( size_t t = 0; t < tokens.size(); t++ ) {
+		unsigned long long previous = tokens[(t + tokens.size() - 1) % tokens.size()].first;
+		// Unsigned subtraction wraps around for the first token
+		unsigned long long arc = tokens[t].first - previous;
+		share[tokens[t].second] += arc / 18446744073709551616.0;
+		if ( tokens.size() == 1 ) {
+			share[tokens[t].second] = 1;
+		}
+
+		int slot = tokens[t].first % LEGACY_RING_SIZE;
+		if ( slotUsed[slot] ) {
+			legacyCollisions++;
+		}
+		slotUsed[slot] = true;
+	}
+
+	double mean = 1.0 / nodeCount;
+	double largest = 0;
+	double variance = 0;
+	for ( int i = 0; i < nodeCount; i++ ) {
+		largest = max(largest, share[i]);
+		variance += (share[i] - mean) * (share[i] - mean) / nodeCount;
+	}
+	printf("%-6s %6d %6d %10.2f %10.3f %10d\n", hashNames[hashType], nodeCount, vnodes,
+			largest / mean, sqrt(variance) / mean, legacyCollisions);
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Run the throughput and balance comparisons for every ring hash
+ **********************************/
+int main(int argc, char *argv[]) {
+	int hashTypes[] = { STD_HASH, FNV1A_HASH, XXH64_HASH };
+	int lengths[] = { 6, 10, 16, 64, 1024 };
+	int nodeCounts[] = { 10, 100, 1000 };
+	int vnodeCounts[] = { 1, 16, 128 };
+
+	srand(1);
+
+	printf("Throughput\n");
+	printf("%-6s %8s %12s %12s\n", "hash", "bytes", "Mhash/s", "MiB/s");
+	for ( int length : lengths ) {
+		for ( int hashType : hashTypes ) {
+			benchThroughput(hashType, length);
+		}
+	}
+
+	printf("\nOwnership balance (max and stddev of node shares, relative to the mean)\n");
+	printf("%-6s %6s %6s %10s %10s %10s\n", "hash", "nodes", "vnodes", "max/mean", "cv", "mod512col");
+	for ( int nodeCount : nodeCounts ) {
+		for ( int vnodes : vnodeCounts ) {
+			for ( int hashType : hashTypes ) {
+				benchBalance(hashType, nodeCount, vnodes);
+			}
+		}
+	}
+
+	return SUCCESS;
+}
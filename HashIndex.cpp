@@ -0,0 +1,156 @@
+/**********************************
+ * FILE NAME: HashIndex.cpp
+ *
+ * DESCRIPTION: HashIndex class definition
+ **********************************/
+
+#include "HashIndex.h"
+
+// A slot holding a negative value is empty
+#define EMPTY_SLOT -1
+
+HashIndex::HashIndex(unsigned long initialCapacity) {
+	unsigned long capacity = 16;
+	while ( capacity < initialCapacity ) {
+		capacity <<= 1;
+	}
+	Slot empty = { 0, EMPTY_SLOT };
+	slots.assign(capacity, empty);
+	mask = capacity - 1;
+	used = 0;
+}
+
+HashIndex::~HashIndex() {}
+
+/**
+ * FUNCTION NAME: mix
+ *
+ * DESCRIPTION: Spread the key bits over the whole word (splitmix64 finalizer) so that
+ * 				keys differing only in their high bits land in different slots
+ */
+unsigned long long HashIndex::mix(unsigned long long key) {
+	key ^= key >> 30;
+	key *= 0xbf58476d1ce4e5b9ULL;
+	key ^= key >> 27;
+	key *= 0x94d049bb133111ebULL;
+	key ^= key >> 31;
+	return key;
+}
+
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: Look up the value stored for a key
+ *
+ * RETURNS:
+ * the value if found
+ * -1 otherwise
+ */
+int HashIndex::find(unsigned long long key) const {
+	for ( unsigned long i = mix(key) & mask; ; i = (i + 1) & mask ) {
+		if ( slots[i].value == EMPTY_SLOT ) {
+			return EMPTY_SLOT;
+		}
+		if ( slots[i].key == key ) {
+			return slots[i].value;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: insert
+ *
+ * DESCRIPTION: Store a non-negative value for a key, replacing any previous value
+ */
+void HashIndex::insert(unsigned long long key, int value) {
+	if ( (used + 1) * 4 > slots.size() * 3 ) {
+		grow();
+	}
+
+	for ( unsigned long i = mix(key) & mask; ; i = (i + 1) & mask ) {
+		if ( slots[i].value == EMPTY_SLOT ) {
+			slots[i].key = key;
+			slots[i].value = value;
+			used++;
+			return;
+		}
+		if ( slots[i].key == key ) {
+			slots[i].value = value;
+			return;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: erase
+ *
+ * DESCRIPTION: Remove a key. Entries further along the probe run are shifted back into
+ * 				the hole when doing so keeps them reachable from their home slot.
+ *
+ * RETURNS:
+ * true if the key was present
+ * false otherwise
+ */
+bool HashIndex::erase(unsigned long long key) {
+	unsigned long hole = mix(key) & mask;
+	while ( slots[hole].value != EMPTY_SLOT && slots[hole].key != key ) {
+		hole = (hole + 1) & mask;
+	}
+	if ( slots[hole].value == EMPTY_SLOT ) {
+		return false;
+	}
+
+	for ( unsigned long i = (hole + 1) & mask; slots[i].value != EMPTY_SLOT; i = (i + 1) & mask ) {
+		unsigned long home = mix(slots[i].key) & mask;
+		// Move the entry only if its home does not lie cyclically in (hole, i]
+		if ( ((i - home) & mask) >= ((i - hole) & mask) ) {
+			slots[hole] = slots[i];
+			hole = i;
+		}
+	}
+	slots[hole].value = EMPTY_SLOT;
+	used--;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Number of keys stored
+ */
+unsigned long HashIndex::size() const {
+	return used;
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Remove every key, keeping the table capacity
+ */
+void HashIndex::clear() {
+	for ( unsigned long i = 0; i < slots.size(); i++ ) {
+		slots[i].value = EMPTY_SLOT;
+	}
+	used = 0;
+}
+
+/**
+ * FUNCTION NAME: grow
+ *
+ * DESCRIPTION: Double the table and re-insert every key
+ */
+void HashIndex::grow() {
+	vector<Slot> old;
+	old.swap(slots);
+
+	Slot empty = { 0, EMPTY_SLOT };
+	slots.assign(old.size() * 2, empty);
+	mask = slots.size() - 1;
+	used = 0;
+
+	for ( unsigned long i = 0; i < old.size(); i++ ) {
+		if ( old[i].value != EMPTY_SLOT ) {
+			insert(old[i].key, old[i].value);
+		}
+	}
+}
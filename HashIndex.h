@@ -0,0 +1,43 @@
+/**********************************
+ * FILE NAME: HashIndex.h
+ *
+ * DESCRIPTION: Header file HashIndex class
+ **********************************/
+
+#ifndef HASHINDEX_H_
+#define HASHINDEX_H_
+
+/**
+ * Header files
+ */
+#include "stdincludes.h"
+
+/**
+ * CLASS NAME: HashIndex
+ *
+ * DESCRIPTION: Open-addressing index from 64-bit keys to positions in a dense array.
+ * 				Linear probing in a power-of-two table, with backward-shift deletion so
+ * 				no tombstones build up under churn.
+ */
+class HashIndex {
+private:
+	struct Slot {
+		unsigned long long key;
+		int value;
+	};
+	vector<Slot> slots;
+	unsigned long used;
+	unsigned long mask;
+	static unsigned long long mix(unsigned long long key);
+	void grow();
+public:
+	HashIndex(unsigned long initialCapacity = 16);
+	int find(unsigned long long key) const;
+	void insert(unsigned long long key, int value);
+	bool erase(unsigned long long key);
+	unsigned long size() const;
+	void clear();
+	virtual ~HashIndex();
+};
+
+#endif /* HASHINDEX_H_ */
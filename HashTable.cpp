@@ -13,15 +13,15 @@ HashTable::~HashTable() {}
 /**
  * FUNCTION NAME: create
  *
- * DESCRIPTION: This function inserts they (key,value) pair into the local hash table
+ * DESCRIPTION: This function inserts they (key,value) pair into the local hash table.
+ * 				An existing key keeps its value if that supersedes the write.
  *
  * RETURNS:
- * true on SUCCESS
- * false in FAILURE
+ * WRITE_APPLIED on SUCCESS
+ * WRITE_STALE if a newer entry was kept
  */
-bool HashTable::create(string key, string value) {
-	hashTable.emplace(key, value);
-	return true;
+WriteResult HashTable::create(StringView key, StringView value, int timestamp, ReplicaType replica) {
+	return upsert(key, value, timestamp, replica);
 }
 
 /**
@@ -33,13 +33,12 @@ bool HashTable::create(string key, string value) {
  * string value if found
  * else it returns a NULL
  */
-string HashTable::read(string key) {
-	map<string, string>::iterator search;
+string HashTable::read(StringView key) {
+	EntryView entry;
 
-	search = hashTable.find(key);
-	if ( search != hashTable.end() ) {
+	if ( find(key, &entry) ) {
 		// Value found
-		return search->second;
+		return entry.value.toString();
 	}
 	else {
 		// Value not found
@@ -47,28 +46,98 @@ string HashTable::read(string key) {
 	}
 }
 
+/**
+ * FUNCTION NAME: read
+ *
+ * DESCRIPTION: This function copies the value of the key into a caller owned string,
+ * 				reusing its storage
+ *
+ * RETURNS:
+ * true if the key was found with a non-empty value
+ * false otherwise
+ */
+bool HashTable::read(StringView key, string &value) {
+	EntryView entry;
+
+	if ( !find(key, &entry) || entry.value.empty() ) {
+		value.clear();
+		return false;
+	}
+	value.assign(entry.value.data(), entry.value.size());
+	return true;
+}
+
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: This function searches for the key without copying its value
+ *
+ * RETURNS:
+ * true if the key is found, with entry viewing the stored entry until the table is next modified
+ * false otherwise
+ */
+bool HashTable::find(StringView key, EntryView *entry) {
+	long search;
+
+	search = hashTable.find(key);
+	if ( search < 0 ) {
+		return false;
+	}
+	return Entry::decode(hashTable.value(search), entry);
+}
+
 /**
  * FUNCTION NAME: update
  *
  * DESCRIPTION: This function updates the given key with the updated value passed in
- * 				if the key is found
+ * 				if the key is found. A write superseded by the stored entry leaves it unchanged.
  *
  * RETURNS:
- * true on SUCCESS
- * false on FAILURE
+ * WRITE_APPLIED on SUCCESS
+ * WRITE_STALE if a newer entry was kept
+ * WRITE_NOT_FOUND if the key is not found
  */
-bool HashTable::update(string key, string newValue) {
-	map<string, string>::iterator update;
+WriteResult HashTable::update(StringView key, StringView newValue, int timestamp, ReplicaType replica) {
+	long update;
+	EntryView stored;
 
-	if (read(key).empty()) {
+	update = hashTable.find(key);
+	if ( update < 0 || !Entry::decode(hashTable.value(update), &stored) || stored.value.empty() ) {
 		// Key not found
-		return false;
+		return WRITE_NOT_FOUND;
+	}
+	if ( !Entry::supersedes(timestamp, newValue, stored) ) {
+		// A newer write already won
+		return WRITE_STALE;
 	}
 	// Key found
-	//update = hashTable.at(key) = newValue;
-	hashTable.at(key) = newValue;
+	Entry::encode(newValue, timestamp, replica, scratch);
+	hashTable.setValue(update, scratch);
 	// Update successful
-	return true;
+	return WRITE_APPLIED;
+}
+
+/**
+ * FUNCTION NAME: upsert
+ *
+ * DESCRIPTION: This function sets the value of the key, creating the key if it is not found,
+ * 				unless the stored entry supersedes the write
+ *
+ * RETURNS:
+ * WRITE_APPLIED if the value was written
+ * WRITE_STALE if a newer entry was kept
+ */
+WriteResult HashTable::upsert(StringView key, StringView value, int timestamp, ReplicaType replica) {
+	bool inserted;
+	long entry = hashTable.findOrInsert(key, &inserted);
+	EntryView stored;
+
+	if ( !inserted && Entry::decode(hashTable.value(entry), &stored) && !Entry::supersedes(timestamp, value, stored) ) {
+		return WRITE_STALE;
+	}
+	Entry::encode(value, timestamp, replica, scratch);
+	hashTable.setValue(entry, scratch);
+	return WRITE_APPLIED;
 }
 
 /**
@@ -80,18 +149,16 @@ bool HashTable::update(string key, string newValue) {
  * true on SUCCESS
  * false on FAILURE
  */
-bool HashTable::deleteKey(string key) {
-	uint eraseCount = 0;
+bool HashTable::deleteKey(StringView key) {
+	long entry;
+	EntryView stored;
 
-	if (read(key).empty()) {
+	entry = hashTable.find(key);
+	if ( entry < 0 || !Entry::decode(hashTable.value(entry), &stored) || stored.value.empty() ) {
 		// Key not found
 		return false;
 	}
-	eraseCount = hashTable.erase(key);
-	if ( eraseCount < 1 ) {
-		// Could not erase
-		return false;
-	}
+	hashTable.erase(entry);
 	// Delete was successful
 	return true;
 }
@@ -138,7 +205,7 @@ void HashTable::clear() {
  * RETURNS:
  * unsigned long count (Should be always 1)
  */
-unsigned long HashTable::count(string key) {
-	return (unsigned long) hashTable.count(key);
+unsigned long HashTable::count(StringView key) {
+	return hashTable.find(key) >= 0 ? 1 : 0;
 }
 
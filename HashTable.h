@@ -13,26 +13,43 @@
 #include "stdincludes.h"
 #include "common.h"
 #include "Entry.h"
+#include "FlatHashMap.h"
+
+/**
+ * Outcome of a write: applied, superseded by the stored version, or refused because
+ * the key is not found
+ */
+enum WriteResult { WRITE_APPLIED, WRITE_STALE, WRITE_NOT_FOUND };
 
 /**
  * CLASS NAME: HashTable
  *
- * DESCRIPTION: This class is a wrapper to the map provided by C++ STL.
+ * DESCRIPTION: This class is a wrapper to an open-addressing FlatHashMap. Keys are kept
+ * 				unordered; nothing iterates them by range. Short keys and values are stored
+ * 				inline in the table, longer ones in its arena.
+ * 				Every key holds a versioned Entry in its stored form; writes resolve
+ * 				conflicts last-writer-wins on the entry timestamp (see Entry::supersedes).
  *
  */
 class HashTable {
+private:
+	// Stored form of the entry being written
+	string scratch;
 public:
-	map<string, string> hashTable;
+	FlatHashMap hashTable;
 //public:
 	HashTable();
-	bool create(string key, string value);
-	string read(string key);
-	bool update(string key, string newValue);
-	bool deleteKey(string key);
+	WriteResult create(StringView key, StringView value, int timestamp = 0, ReplicaType replica = PRIMARY);
+	string read(StringView key);
+	bool read(StringView key, string &value);
+	bool find(StringView key, EntryView *entry);
+	WriteResult update(StringView key, StringView newValue, int timestamp = 0, ReplicaType replica = PRIMARY);
+	WriteResult upsert(StringView key, StringView value, int timestamp = 0, ReplicaType replica = PRIMARY);
+	bool deleteKey(StringView key);
 	bool isEmpty();
 	unsigned long currentSize();
 	void clear();
-	unsigned long count(string key);
+	unsigned long count(StringView key);
 	virtual ~HashTable();
 };
 
@@ -40,13 +40,14 @@ Log::~Log() {}
  * FUNCTION NAME: LOG
  *
  * DESCRIPTION: Print out to file dbg.log, along with Address of node.
+ * 				The message buffer grows to fit messages carrying long keys or values.
  */
 void Log::LOG(Address *addr, const char * str, ...) {
 
 	static FILE *fp;
 	static FILE *fp2;
 	va_list vararglist;
-	static char buffer[30000];
+	static vector<char> buffer(30000);
 	static int numwrites;
 	static char stdstring[30];
 	static char stdstring2[40];
@@ -70,11 +71,17 @@ void Log::LOG(Address *addr, const char * str, ...) {
 	}
 	else 
 
-	sprintf(stdstring, "%d.%d.%d.%d:%d ", addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], *(short *)&addr->addr[4]);
+	snprintf(stdstring, sizeof(stdstring), "%d.%d.%d.%d:%d ", addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], *(short *)&addr->addr[4]);
 
 	va_start(vararglist, str);
-	vsprintf(buffer, str, vararglist);
+	int length = vsnprintf(buffer.data(), buffer.size(), str, vararglist);
 	va_end(vararglist);
+	if ( length >= (int) buffer.size() ) {
+		buffer.resize(length + 1);
+		va_start(vararglist, str);
+		vsnprintf(buffer.data(), buffer.size(), str, vararglist);
+		va_end(vararglist);
+	}
 
 	if (!firstTime) {
 		int magicNumber = 0;
@@ -87,16 +94,16 @@ void Log::LOG(Address *addr, const char * str, ...) {
 		firstTime = true;
 	}
 
-	if(memcmp(buffer, "#STATSLOG#", 10)==0){
+	if(strncmp(buffer.data(), "#STATSLOG#", 10)==0){
 		fprintf(fp2, "\n %s", stdstring);
 		fprintf(fp2, "[%d] ", par->getcurrtime());
 
-		fprintf(fp2, buffer);
+		fputs(buffer.data(), fp2);
 	}
 	else{
 		fprintf(fp, "\n %s", stdstring);
 		fprintf(fp, "[%d] ", par->getcurrtime());
-		fprintf(fp, buffer);
+		fputs(buffer.data(), fp);
 
 	}
 
@@ -114,9 +121,7 @@ void Log::LOG(Address *addr, const char * str, ...) {
  * DESCRIPTION: To Log a node add
  */
 void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
-	static char stdstring[100];
-	sprintf(stdstring, "Node %d.%d.%d.%d:%d joined at time %d", addedAddr->addr[0], addedAddr->addr[1], addedAddr->addr[2], addedAddr->addr[3], *(short *)&addedAddr->addr[4], par->getcurrtime());
-    LOG(thisNode, stdstring);
+	LOG(thisNode, "Node %d.%d.%d.%d:%d joined at time %d", addedAddr->addr[0], addedAddr->addr[1], addedAddr->addr[2], addedAddr->addr[3], *(short *)&addedAddr->addr[4], par->getcurrtime());
 }
 
 /**
@@ -125,9 +130,7 @@ void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
  * DESCRIPTION: To log a node remove
  */
 void Log::logNodeRemove(Address *thisNode, Address *removedAddr) {
-	static char stdstring[30];
-	sprintf(stdstring, "Node %d.%d.%d.%d:%d removed at time %d", removedAddr->addr[0], removedAddr->addr[1], removedAddr->addr[2], removedAddr->addr[3], *(short *)&removedAddr->addr[4], par->getcurrtime());
-    LOG(thisNode, stdstring);
+	LOG(thisNode, "Node %d.%d.%d.%d:%d removed at time %d", removedAddr->addr[0], removedAddr->addr[1], removedAddr->addr[2], removedAddr->addr[3], *(short *)&removedAddr->addr[4], par->getcurrtime());
 }
 
 /**
@@ -135,15 +138,13 @@ void Log::logNodeRemove(Address *thisNode, Address *removedAddr) {
  *
  * DESCRTION: Call this function after successfully create a key value pair
  */
-void Log::logCreateSuccess(Address * address, bool isCoordinator, int transID, string key, string value){
-	static char stdstring[100];
+void Log::logCreateSuccess(Address * address, bool isCoordinator, int transID, StringView key, StringView value){
 	string str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: create success at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(), transID, key.c_str(), value.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: create success at time %d, transID=%d, key=%.*s, value=%.*s", str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data(), (int) value.size(), value.data());
 }
 
 /**
@@ -151,15 +152,13 @@ void Log::logCreateSuccess(Address * address, bool isCoordinator, int transID, s
  *
  * DESCRIPTION: Call this function after successfully reading a key
  */
-void Log::logReadSuccess(Address * address, bool isCoordinator, int transID, string key, string value){
-    static char stdstring[100];
+void Log::logReadSuccess(Address * address, bool isCoordinator, int transID, StringView key, StringView value){
 	string str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: read success at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(), transID, key.c_str(), value.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: read success at time %d, transID=%d, key=%.*s, value=%.*s", str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data(), (int) value.size(), value.data());
 }
 
 /**
@@ -167,15 +166,13 @@ void Log::logReadSuccess(Address * address, bool isCoordinator, int transID, str
  *
  * DESCRIPTION: Call this function after successfully updating a key
  */
-void Log::logUpdateSuccess(Address * address, bool isCoordinator, int transID, string key, string newValue){
-    static char stdstring[100];
+void Log::logUpdateSuccess(Address * address, bool isCoordinator, int transID, StringView key, StringView newValue){
 	string str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: update success at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(), transID, key.c_str(), newValue.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: update success at time %d, transID=%d, key=%.*s, value=%.*s", str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data(), (int) newValue.size(), newValue.data());
 }
 
 /**
@@ -183,15 +180,13 @@ void Log::logUpdateSuccess(Address * address, bool isCoordinator, int transID, s
  *
  * DESCRIPTION: Call this function after successfully deleting a key
  */
-void Log::logDeleteSuccess(Address * address, bool isCoordinator, int transID, string key){
-    static char stdstring[100];
+void Log::logDeleteSuccess(Address * address, bool isCoordinator, int transID, StringView key){
 	string str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: delete success at time %d, transID=%d, key=%s", str.c_str(), par->getcurrtime(), transID, key.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: delete success at time %d, transID=%d, key=%.*s", str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data());
 }
 
 /**
@@ -199,15 +194,13 @@ void Log::logDeleteSuccess(Address * address, bool isCoordinator, int transID, s
  *
  * DESCRIPTION: Call this function if CREATE failed
  */
-void Log::logCreateFail(Address * address, bool isCoordinator, int transID, string key, string value){
-	static char stdstring[100];
+void Log::logCreateFail(Address * address, bool isCoordinator, int transID, StringView key, StringView value){
 	string str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: create fail at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(), transID, key.c_str(), value.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: create fail at time %d, transID=%d, key=%.*s, value=%.*s", str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data(), (int) value.size(), value.data());
 }
 
 
@@ -216,15 +209,13 @@ void Log::logCreateFail(Address * address, bool isCoordinator, int transID, stri
  *
  * DESCRIPTION: Call this function if READ failed
  */
-void Log::logReadFail(Address * address, bool isCoordinator, int transID, string key){
-    static char stdstring[100];
+void Log::logReadFail(Address * address, bool isCoordinator, int transID, StringView key){
 	string str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: read fail at time %d, transID=%d, key=%s", str.c_str(), par->getcurrtime(), transID, key.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: read fail at time %d, transID=%d, key=%.*s", str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data());
 }
 
 /**
@@ -232,15 +223,13 @@ void Log::logReadFail(Address * address, bool isCoordinator, int transID, string
  *
  * DESCRIPTION: Call this function if UPDATE failed
  */
-void Log::logUpdateFail(Address * address, bool isCoordinator, int transID, string key, string newValue){
-    static char stdstring[100];
+void Log::logUpdateFail(Address * address, bool isCoordinator, int transID, StringView key, StringView newValue){
 	string str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: update fail at time %d, transID=%d, key=%s, value=%s", str.c_str(), par->getcurrtime(), transID, key.c_str(), newValue.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: update fail at time %d, transID=%d, key=%.*s, value=%.*s", str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data(), (int) newValue.size(), newValue.data());
 }
 
 /**
@@ -248,13 +237,11 @@ void Log::logUpdateFail(Address * address, bool isCoordinator, int transID, stri
  *
  * DESCRIPTION: Call this function if DELETE failed
  */
-void Log::logDeleteFail(Address * address, bool isCoordinator, int transID, string key){
-    static char stdstring[100];
+void Log::logDeleteFail(Address * address, bool isCoordinator, int transID, StringView key){
 	string str;
 	if (isCoordinator)
 		str = "coordinator";
 	else
 		str = "server";
-	sprintf(stdstring, "%s: delete fail at time %d, transID=%d, key=%s", str.c_str(), par->getcurrtime(), transID, key.c_str());
-    LOG(address, stdstring);
+	LOG(address, "%s: delete fail at time %d, transID=%d, key=%.*s", str.c_str(), par->getcurrtime(), transID, (int) key.size(), key.data());
 }
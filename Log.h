@@ -10,6 +10,7 @@
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "StringView.h"
 
 /*
  * Macros
@@ -38,15 +39,15 @@ public:
 	void logNodeAdd(Address *, Address *);
 	void logNodeRemove(Address *, Address *);
 	// success
-	void logCreateSuccess(Address * address, bool isCoordinator, int transID, string key, string value);
-	void logReadSuccess(Address * address, bool isCoordinator, int transID, string key, string value);
-	void logUpdateSuccess(Address * address, bool isCoordinator, int transID, string key, string newValue);
-	void logDeleteSuccess(Address * address, bool isCoordinator, int transID, string key);
+	void logCreateSuccess(Address * address, bool isCoordinator, int transID, StringView key, StringView value);
+	void logReadSuccess(Address * address, bool isCoordinator, int transID, StringView key, StringView value);
+	void logUpdateSuccess(Address * address, bool isCoordinator, int transID, StringView key, StringView newValue);
+	void logDeleteSuccess(Address * address, bool isCoordinator, int transID, StringView key);
 	// fail
-	void logCreateFail(Address * address, bool isCoordinator, int transID, string key, string value);
-	void logReadFail(Address * address, bool isCoordinator, int transID, string key);
-	void logUpdateFail(Address * address, bool isCoordinator, int transID, string key, string newValue);
-	void logDeleteFail(Address * address, bool isCoordinator, int transID, string key);
+	void logCreateFail(Address * address, bool isCoordinator, int transID, StringView key, StringView value);
+	void logReadFail(Address * address, bool isCoordinator, int transID, StringView key);
+	void logUpdateFail(Address * address, bool isCoordinator, int transID, StringView key, StringView newValue);
+	void logDeleteFail(Address * address, bool isCoordinator, int transID, StringView key);
 };
 
 #endif /* _LOG_H_ */
@@ -25,6 +25,15 @@ MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Addres
     this->log = log;
     this->par = params;
     this->memberNode->addr = *address;
+    this->gossipRound = 0;
+    this->incarnation = 0;
+    this->probeSeq = 0;
+    this->probeActive = false;
+    this->probeAcked = false;
+    this->probeIndirectSent = false;
+    this->probeTime = 0;
+    this->probeIndex = 0;
+    this->phiCrossing = phiCrossingPoint(params->PHI_THRESHOLD);
 }
 
 /**
@@ -102,7 +111,7 @@ int MP1Node::initThisNode(Address *joinaddr) {
     // node is up!
     memberNode->nnb = 0;
     memberNode->heartbeat = 0;
-    memberNode->pingCounter = TFAIL;
+    memberNode->pingCounter = par->GOSSIP_PERIOD;
     memberNode->timeOutCounter = -1;
     initMemberListTable(memberNode);
 
@@ -115,7 +124,6 @@ int MP1Node::initThisNode(Address *joinaddr) {
  * DESCRIPTION: Join the distributed system
  */
 int MP1Node::introduceSelfToGroup(Address *joinaddr) {
-//    MessageHdr *msg;
 #ifdef DEBUGLOG
     static char s[1024];
 #endif
@@ -127,22 +135,13 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 #endif
         memberNode->inGroup = true;
     } else {
-
-        // Create JOINREQ message
-        auto *msg = new MessageHdr();
-        msg->msgType = JOINREQ;
-        msg->memberVector = memberNode->memberList;
-        msg->addr = &memberNode->addr;
-
 #ifdef DEBUGLOG
         sprintf(s, "Trying to join...");
         log->LOG(&memberNode->addr, s);
 #endif
 
         // send JOINREQ message to introducer member
-        emulNet->ENsend(&memberNode->addr, joinaddr, (char *) msg, sizeof(MessageHdr));
-
-        free(msg);
+        sendMessage(joinaddr, JOINREQ);
     }
 
     return 1;
@@ -197,6 +196,7 @@ void MP1Node::checkMessages() {
         size = memberNode->mp1q.front().size;
         memberNode->mp1q.pop();
         recvCallBack((void *) memberNode, (char *) ptr, size);
+        emulNet->ENrelease((char *) ptr);
     }
 }
 
@@ -206,42 +206,55 @@ void MP1Node::checkMessages() {
  * DESCRIPTION: Message handler for different message types
  */
 bool MP1Node::recvCallBack(void *env, char *data, int size) {
-    /*
-     * Your code goes here
-     */
+    MessageHdr msg;
+    auto *msgReceived = &msg;
+
+    if (size > 0 && (data[0] == PROBE || data[0] == ACK || data[0] == PINGREQ)) {
+        SwimMessage swimMsg;
+        if (!decodeSwimMessage(data, size, &swimMsg))
+            return false;
+
+        swimHandler(&swimMsg);
+        return true;
+    }
+
+    if (!decodeMessage(data, size, msgReceived))
+        return false;
 
-    auto *msgReceived = (MessageHdr*) data;
     if (msgReceived->msgType == JOINREQ || msgReceived->msgType == JOINREP) {
         pushNodeToMembershipList(msgReceived);
 
         if (msgReceived->msgType == JOINREQ)
-            sendMessage(msgReceived->addr, JOINREP);
+            sendMessage(&msgReceived->addr, JOINREP);
 
         if (msgReceived->msgType == JOINREP)
             memberNode->inGroup = true;
+
+        if (par->FAILURE_DETECTOR == SWIM_DETECTOR)
+            swimJoinHandler(msgReceived);
     }
 
     if (msgReceived->msgType == PING)
         pingHandler(msgReceived);
 
-    delete msgReceived;
     return true;
 }
 
 void MP1Node::pushNodeToMembershipList(MessageHdr *msg) {
     int id = 0;
     short port;
-    long heartbeat = 1;
+    long heartbeat = msg->heartbeat;
     long timestamp = this->par->getcurrtime();
 
     // Compose the address
-    memcpy(&id, &msg->addr->addr[0], sizeof(int));
-    memcpy(&port, &msg->addr->addr[4], sizeof(short));
+    memcpy(&id, &msg->addr.addr[0], sizeof(int));
+    memcpy(&port, &msg->addr.addr[4], sizeof(short));
 
     if (checkMemberList(id, port) != nullptr)
         return;
 
-    memberNode->memberList.emplace_back(id, port, heartbeat, timestamp);
+    addMember(id, port, heartbeat, timestamp);
+    ownerHeartbeats.insert(memberKey(id, port));
 
     log->logNodeAdd(&memberNode->addr, getAddress(id, port));
 }
@@ -254,14 +267,45 @@ void MP1Node::pushNodeToMembershipList(MemberListEntry *entry) {
         return;
     }
 
+    if (par->FAILURE_DETECTOR == PHI_DETECTOR) {
+        auto removed = removedMembers.find(memberKey(entry->id, entry->port));
+        if (removed != removedMembers.end() && entry->timestamp <= removed->second) {
+            delete entryAddress;
+            return;
+        }
+    }
+
     if (par->getcurrtime() - entry->timestamp < TREMOVE) {
         log->logNodeAdd(&memberNode->addr, entryAddress);
-        memberNode->memberList.push_back(*entry);
+        addMember(entry->id, entry->port, entry->heartbeat, entry->timestamp);
     }
 
     delete entryAddress;
 }
 
+/**
+ * FUNCTION NAME: addMember
+ *
+ * DESCRIPTION: Append a member to the membership list, index its position and publish
+ * 				the join to the key-value store
+ */
+void MP1Node::addMember(int id, short port, long heartbeat, long timestamp) {
+    unsigned long long key = memberKey(id, port);
+
+    memberIndex.insert(key, memberNode->memberList.size());
+    memberNode->memberList.emplace_back(id, port, heartbeat, timestamp);
+    removedMembers.erase(key);
+
+    MemberEvent event;
+    memcpy(&event.addr.addr[0], &id, sizeof(int));
+    memcpy(&event.addr.addr[4], &port, sizeof(short));
+    event.joined = true;
+    memberNode->memberEvents.push_back(event);
+
+    if (par->FAILURE_DETECTOR != SWIM_DETECTOR)
+        expiryTimers.insert(key, expiryWheel.schedule(key, timestamp + TREMOVE));
+}
+
 Address *MP1Node::getAddress(int id, short port) {
     auto *address = new Address();
     memcpy(&address->addr[0], &id, sizeof(int));
@@ -272,65 +316,178 @@ Address *MP1Node::getAddress(int id, short port) {
 
 
 MemberListEntry *MP1Node::checkMemberList(int id, short port) {
-    for (auto &i : memberNode->memberList) {
-        if (i.id == id && i.port == port)
-            return &i;
-    }
+    int index = memberIndex.find(memberKey(id, port));
+
+    if (index < 0)
+        return nullptr;
 
-    return nullptr;
+    return &memberNode->memberList[index];
 }
 
 MemberListEntry *MP1Node::checkMemberList(Address *nodeAddress) {
-    for (auto &i : memberNode->memberList) {
-        int id = 0;
-        short port = 0;
+    int id = 0;
+    short port = 0;
+
+    memcpy(&id, &nodeAddress->addr[0], sizeof(int));
+    memcpy(&port, &nodeAddress->addr[4], sizeof(short));
+
+    return checkMemberList(id, port);
+}
 
-        memcpy(&id, &nodeAddress->addr[0], sizeof(int));
-        memcpy(&port, &nodeAddress->addr[4], sizeof(short));
+void MP1Node::sendMessage(Address *addressDestino, MsgTypes msgType) {
+    vector<int> entries(memberNode->memberList.size());
+    for (unsigned int i = 0; i < entries.size(); i++)
+        entries[i] = i;
+
+    sendMessage(addressDestino, msgType, entries);
+}
+
+void MP1Node::sendMessage(Address *addressDestino, MsgTypes msgType, vector<int> &entries) {
+    int capacity = min(MP1_HEADER_SIZE + (int) entries.size() * MP1_ENTRY_SIZE, emulNet->ENmaxPayload());
+    char *buffer = emulNet->ENbuffer(capacity);
 
-        if (i.id == id && i.port == port)
-            return &i;
+    int size = encodeMessage(buffer, capacity, msgType, entries);
+
+    emulNet->ENsendBuffer(&memberNode->addr, addressDestino, buffer, size);
+}
+
+/**
+ * FUNCTION NAME: encodeMessage
+ *
+ * DESCRIPTION: Write a message of the given type into buffer, packing as many of the
+ * 				listed membership list positions as fit in capacity bytes
+ *
+ * RETURNS:
+ * number of bytes written
+ */
+int MP1Node::encodeMessage(char *buffer, int capacity, MsgTypes msgType, vector<int> &entries) {
+    unsigned short count = min((capacity - MP1_HEADER_SIZE) / MP1_ENTRY_SIZE, (int) entries.size());
+    char *ptr = buffer;
+
+    *ptr++ = (char) msgType;
+    memcpy(ptr, memberNode->addr.addr, sizeof(memberNode->addr.addr));
+    ptr += sizeof(memberNode->addr.addr);
+    int ownHeartbeat = (int) memberNode->heartbeat;
+    memcpy(ptr, &ownHeartbeat, sizeof(int));
+    ptr += sizeof(int);
+    memcpy(ptr, &count, sizeof(unsigned short));
+    ptr += sizeof(unsigned short);
+
+    for (int i = 0; i < count; i++) {
+        MemberListEntry &entry = memberNode->memberList[entries[i]];
+        int heartbeat = (int) entry.heartbeat;
+        unsigned short age = (unsigned short) min(par->getcurrtime() - entry.timestamp, (long) MP1_MAX_AGE);
+
+        memcpy(ptr, &entry.id, sizeof(int));
+        memcpy(ptr + 4, &entry.port, sizeof(short));
+        memcpy(ptr + 6, &heartbeat, sizeof(int));
+        memcpy(ptr + 10, &age, sizeof(unsigned short));
+        ptr += MP1_ENTRY_SIZE;
     }
 
-    return nullptr;
+    return (int) (ptr - buffer);
 }
 
-void MP1Node::sendMessage(Address *addressDestino, MsgTypes msgType) {
-    auto *msgEnviar = new MessageHdr();
-    msgEnviar->msgType = msgType;
-    msgEnviar->memberVector = memberNode->memberList;
-    msgEnviar->addr = &memberNode->addr;
+/**
+ * FUNCTION NAME: memberKey
+ *
+ * DESCRIPTION: Pack the id and port of a member into a single key
+ */
+unsigned long long MP1Node::memberKey(int id, short port) {
+    return ((unsigned long long) (unsigned int) id << 16) | (unsigned short) port;
+}
 
-    emulNet->ENsend(&memberNode->addr, addressDestino, (char *) msgEnviar, sizeof(MessageHdr));
+/**
+ * FUNCTION NAME: decodeMessage
+ *
+ * DESCRIPTION: Decode the header of a received message without copying its entries
+ *
+ * RETURNS:
+ * false if the message is truncated or of an unknown type
+ */
+bool MP1Node::decodeMessage(char *data, int size, MessageHdr *msg) {
+    unsigned short count;
+
+    if (size < MP1_HEADER_SIZE)
+        return false;
+
+    msg->msgType = (MsgTypes) data[0];
+    if (msg->msgType != JOINREQ && msg->msgType != JOINREP && msg->msgType != PING)
+        return false;
+
+    int heartbeat;
+    memcpy(msg->addr.addr, data + 1, sizeof(msg->addr.addr));
+    memcpy(&heartbeat, data + 7, sizeof(int));
+    memcpy(&count, data + 11, sizeof(unsigned short));
+    msg->heartbeat = heartbeat;
+
+    if (size < MP1_HEADER_SIZE + count * MP1_ENTRY_SIZE)
+        return false;
+
+    msg->memberCount = count;
+    msg->members = data + MP1_HEADER_SIZE;
+    return true;
+}
+
+/**
+ * FUNCTION NAME: decodeMemberEntry
+ *
+ * DESCRIPTION: Unpack the index-th member entry of a decoded message. The timestamp
+ * 				is rebuilt from the age of the entry at the sender plus the time unit
+ * 				the message spent in the network
+ */
+void MP1Node::decodeMemberEntry(MessageHdr *msg, int index, MemberListEntry *entry) {
+    const char *ptr = msg->members + index * MP1_ENTRY_SIZE;
+    int heartbeat;
+    unsigned short age;
+
+    memcpy(&entry->id, ptr, sizeof(int));
+    memcpy(&entry->port, ptr + 4, sizeof(short));
+    memcpy(&heartbeat, ptr + 6, sizeof(int));
+    memcpy(&age, ptr + 10, sizeof(unsigned short));
+
+    entry->heartbeat = heartbeat;
+    entry->timestamp = par->getcurrtime() - age - 1;
 }
 
 void MP1Node::pingHandler(MessageHdr *msgReceived) {
     updateSrcMember(msgReceived);
 
-    for (auto &i : msgReceived->memberVector) {
-        if (i.id > 10 || i.id < 0)
-            assert(false); // Pa q se rompa
+    MemberListEntry i;
+    for (int index = 0; index < msgReceived->memberCount; index++) {
+        decodeMemberEntry(msgReceived, index, &i);
 
         MemberListEntry *node = checkMemberList(i.id, i.port);
 
         if (node == nullptr) {
             pushNodeToMembershipList(&i);
-            return;
+            continue;
         }
 
         if (i.heartbeat > node->heartbeat) {
             node->heartbeat = i.heartbeat;
-            node->timestamp = par->getcurrtime();
+            ownerHeartbeats.erase(memberKey(i.id, i.port));
+            refreshMember(node);
         }
     }
 }
 
+/**
+ * FUNCTION NAME: updateSrcMember
+ *
+ * DESCRIPTION: Take the sender's own heartbeat, carried in the message header. Like any
+ * 				gossiped entry, it only refreshes the member when it is higher than the
+ * 				one held, so every node holds the same heartbeat values for a member.
+ */
 void MP1Node::updateSrcMember(MessageHdr *msgReceived) {
-    MemberListEntry *srcMember = checkMemberList(msgReceived->addr);
+    MemberListEntry *srcMember = checkMemberList(&msgReceived->addr);
 
     if (srcMember != nullptr) {
-        srcMember->heartbeat++;
-        srcMember->timestamp = par->getcurrtime();
+        if (msgReceived->heartbeat > srcMember->heartbeat) {
+            srcMember->heartbeat = msgReceived->heartbeat;
+            ownerHeartbeats.insert(memberKey(srcMember->id, srcMember->port));
+            refreshMember(srcMember);
+        }
 
         return;
     }
@@ -348,24 +505,659 @@ void MP1Node::updateSrcMember(MessageHdr *msgReceived) {
 void MP1Node::nodeLoopOps() {
     memberNode->heartbeat++;
 
-    for (int i = memberNode->memberList.size() - 1; i >= 0; i--) {
-        if (par->getcurrtime() - memberNode->memberList[i].timestamp >= TREMOVE) {
-            Address *removedAddress = getAddress(memberNode->memberList[i].id, memberNode->memberList[i].port);
-            log->logNodeRemove(&memberNode->addr, removedAddress);
-            memberNode->memberList.erase(memberNode->memberList.begin() + i);
-
-            delete removedAddress;
-        }
+    if (par->FAILURE_DETECTOR == SWIM_DETECTOR) {
+        swimLoopOps();
+        return;
     }
 
-    for (auto &i : memberNode->memberList) {
+    expireMembers();
+
+    // Gossip once every GOSSIP_PERIOD time units
+    if (--memberNode->pingCounter > 0)
+        return;
+    memberNode->pingCounter = par->GOSSIP_PERIOD;
+
+    vector<int> targets;
+    vector<int> entries;
+    selectGossipTargets(targets);
+    selectGossipEntries(entries);
+
+    for (int target : targets) {
+        MemberListEntry &i = memberNode->memberList[target];
         Address *address = getAddress(i.id, i.port);
-        sendMessage(address, PING);
+        sendMessage(address, PING, entries);
 
         delete address;
     }
 }
 
+/**
+ * FUNCTION NAME: selectGossipEntries
+ *
+ * DESCRIPTION: Pick the membership list positions carried by this gossip round: the
+ * 				entries whose heartbeat went up since they were last gossiped, or the
+ * 				whole list every GOSSIP_FULL_SYNC rounds to repair anything that was lost.
+ * 				With a full fan-out every member already got a heartbeat that came from
+ * 				its owner, straight from the owner, so only the ones learned through
+ * 				gossip are passed on between full rounds.
+ */
+void MP1Node::selectGossipEntries(vector<int> &entries) {
+    bool fullSync = par->GOSSIP_FULL_SYNC <= 0 || gossipRound % par->GOSSIP_FULL_SYNC == 0;
+    bool fullFanout = par->GOSSIP_FANOUT <= 0 || par->GOSSIP_FANOUT >= (int) memberNode->memberList.size();
+    gossipRound++;
+
+    entries.clear();
+    for (unsigned int i = 0; i < memberNode->memberList.size(); i++) {
+        MemberListEntry &entry = memberNode->memberList[i];
+        unsigned long long key = memberKey(entry.id, entry.port);
+        auto gossiped = gossipedHeartbeats.find(key);
+
+        if (gossiped == gossipedHeartbeats.end()) {
+            gossipedHeartbeats.emplace(key, entry.heartbeat);
+            entries.push_back(i);
+            continue;
+        }
+
+        bool raised = entry.heartbeat > gossiped->second;
+        gossiped->second = entry.heartbeat;
+        if (fullSync || (raised && !(fullFanout && ownerHeartbeats.count(key))))
+            entries.push_back(i);
+    }
+}
+
+/**
+ * FUNCTION NAME: removeMember
+ *
+ * DESCRIPTION: Drop the member at the given position of the membership list and publish
+ * 				the leave. The last member is moved into the freed position.
+ */
+void MP1Node::removeMember(int index) {
+    vector<MemberListEntry> &memberList = memberNode->memberList;
+    MemberListEntry &entry = memberList[index];
+    unsigned long long key = memberKey(entry.id, entry.port);
+    Address *removedAddress = getAddress(entry.id, entry.port);
+
+    log->logNodeRemove(&memberNode->addr, removedAddress);
+    gossipedHeartbeats.erase(key);
+    ownerHeartbeats.erase(key);
+    phiWindows.erase(key);
+    memberIndex.erase(key);
+    if (par->FAILURE_DETECTOR == PHI_DETECTOR) {
+        removedMembers[key] = par->getcurrtime();
+        removedWheel.schedule(key, par->getcurrtime() + TREMOVE);
+    }
+
+    MemberRemoval removal = { *removedAddress, par->getcurrtime() };
+    removals.push_back(removal);
+
+    MemberEvent event = { *removedAddress, false };
+    memberNode->memberEvents.push_back(event);
+
+    int timer = expiryTimers.find(key);
+    if (timer >= 0) {
+        expiryWheel.cancel(timer);
+        expiryTimers.erase(key);
+    }
+
+    if (index != (int) memberList.size() - 1) {
+        memberList[index] = memberList.back();
+        memberIndex.insert(memberKey(memberList[index].id, memberList[index].port), index);
+    }
+    memberList.pop_back();
+
+    delete removedAddress;
+}
+
+/**
+ * FUNCTION NAME: expireMembers
+ *
+ * DESCRIPTION: Remove the members not refreshed in TREMOVE time units. Only the members
+ * 				whose expiry timer is due are visited; a timer that fires for a member
+ * 				refreshed in the meantime is re-armed at its new expiry time. Also drops
+ * 				the phi-accrual removal tombstones that have aged past TREMOVE.
+ */
+void MP1Node::expireMembers() {
+    vector<unsigned long long> due;
+    expiryWheel.advance(par->getcurrtime(), due);
+
+    for (unsigned long long key : due) {
+        // The timer fired, so its handle is gone
+        expiryTimers.erase(key);
+
+        int index = memberIndex.find(key);
+        if (index < 0)
+            continue;
+
+        long expiry = expiryTime(&memberNode->memberList[index]);
+        if (expiry <= par->getcurrtime())
+            removeMember(index);
+        else
+            expiryTimers.insert(key, expiryWheel.schedule(key, expiry));
+    }
+
+    // Drop the tombstones TREMOVE old; a timer left by an earlier removal of a member
+    // removed again since finds a newer tombstone and leaves it
+    due.clear();
+    removedWheel.advance(par->getcurrtime(), due);
+    for (unsigned long long key : due) {
+        auto removed = removedMembers.find(key);
+        if (removed != removedMembers.end() && removed->second + TREMOVE <= par->getcurrtime())
+            removedMembers.erase(removed);
+    }
+}
+
+/**
+ * FUNCTION NAME: refreshMember
+ *
+ * DESCRIPTION: Record fresh evidence that a member is alive. The phi-accrual detector
+ * 				also logs the inter-arrival time and moves the member's expiry timer.
+ */
+void MP1Node::refreshMember(MemberListEntry *entry) {
+    long now = par->getcurrtime();
+
+    if (par->FAILURE_DETECTOR != PHI_DETECTOR || now <= entry->timestamp) {
+        entry->timestamp = now;
+        return;
+    }
+
+    unsigned long long key = memberKey(entry->id, entry->port);
+    PhiWindow &window = phiWindows[key];
+
+    window.intervals[window.next] = now - entry->timestamp;
+    window.next = (window.next + 1) % PHI_WINDOW_SIZE;
+    if (window.count < PHI_WINDOW_SIZE)
+        window.count++;
+    entry->timestamp = now;
+
+    int timer = expiryTimers.find(key);
+    if (timer >= 0)
+        expiryWheel.reschedule(timer, expiryTime(entry));
+}
+
+/**
+ * FUNCTION NAME: expiryTime
+ *
+ * DESCRIPTION: Time at which a member is removed if not refreshed. That is TREMOVE after
+ * 				its last refresh, or with the phi-accrual detector the earlier time at
+ * 				which phi reaches PHI_THRESHOLD, once enough inter-arrivals are known.
+ */
+long MP1Node::expiryTime(MemberListEntry *entry) {
+    long expiry = entry->timestamp + TREMOVE;
+
+    if (par->FAILURE_DETECTOR != PHI_DETECTOR)
+        return expiry;
+
+    auto found = phiWindows.find(memberKey(entry->id, entry->port));
+    if (found == phiWindows.end() || found->second.count < PHI_MIN_SAMPLES)
+        return expiry;
+
+    PhiWindow &window = found->second;
+    double mean = 0, variance = 0;
+    for (int i = 0; i < window.count; i++)
+        mean += window.intervals[i];
+    mean /= window.count;
+    for (int i = 0; i < window.count; i++)
+        variance += (window.intervals[i] - mean) * (window.intervals[i] - mean);
+    double stddev = max(sqrt(variance / window.count), PHI_MIN_STDDEV);
+
+    return min(expiry, entry->timestamp + (long) ceil(mean + phiCrossing * stddev));
+}
+
+/**
+ * FUNCTION NAME: phiCrossingPoint
+ *
+ * DESCRIPTION: Phi after a silence t is -log10(1 - F(t)), F being the normal CDF fitted to
+ * 				the inter-arrival times, approximated with the logistic function
+ * 				1 / (1 + e^(-y(1.5976 + 0.070566y^2))) of y = (t - mean) / stddev.
+ * 				Phi grows with y, so the silence at which it reaches the threshold
+ * 				is a fixed number of deviations past the mean, found here by bisection.
+ *
+ * RETURNS:
+ * the y at which phi equals the threshold
+ */
+double MP1Node::phiCrossingPoint(double threshold) {
+    double target = ::log(pow(10.0, threshold) - 1.0);
+    double low = 0, high = 100;
+
+    for (int i = 0; i < 100; i++) {
+        double y = (low + high) / 2;
+        if (y * (1.5976 + 0.070566 * y * y) < target)
+            low = y;
+        else
+            high = y;
+    }
+
+    return high;
+}
+
+/**
+ * FUNCTION NAME: selectGossipTargets
+ *
+ * DESCRIPTION: Pick the positions in the membership list to gossip to this round:
+ * 				GOSSIP_FANOUT members chosen uniformly at random, or every member
+ * 				when the fan-out is 0 or not smaller than the list
+ */
+void MP1Node::selectGossipTargets(vector<int> &targets) {
+    int size = memberNode->memberList.size();
+    int fanout = par->GOSSIP_FANOUT;
+
+    targets.resize(size);
+    for (int i = 0; i < size; i++)
+        targets[i] = i;
+
+    if (fanout <= 0 || fanout >= size)
+        return;
+
+    // Partial Fisher-Yates shuffle: the first fanout positions are a random sample
+    for (int i = 0; i < fanout; i++) {
+        int j = i + rand() % (size - i);
+        swap(targets[i], targets[j]);
+    }
+    targets.resize(fanout);
+}
+
+/**
+ * FUNCTION NAME: swimLoopOps
+ *
+ * DESCRIPTION: One time unit of the SWIM failure detector. Every SWIM_PERIOD a single
+ * 				member is probed directly; if it has not acked within SWIM_PROBE_TIMEOUT,
+ * 				SWIM_INDIRECT_PROBES other members are asked to probe it. A member still
+ * 				silent at the end of the period becomes suspect, and a suspect that does
+ * 				not refute within swimSuspectTimeout is confirmed failed and removed.
+ * 				Membership updates travel piggybacked on the probe traffic, and every
+ * 				period each suspect is probed directly, so it hears of the suspicion
+ * 				and can refute it straight back to the suspector.
+ */
+void MP1Node::swimLoopOps() {
+    long now = par->getcurrtime();
+
+    // Indirect probes once the direct probe timed out
+    if (probeActive && !probeAcked && !probeIndirectSent && now - probeTime >= SWIM_PROBE_TIMEOUT) {
+        vector<int> helpers;
+        for (unsigned int i = 0; i < memberNode->memberList.size(); i++) {
+            MemberListEntry &entry = memberNode->memberList[i];
+            if (memberKey(entry.id, entry.port) != memberKey(*(int *) probeTarget.addr, *(short *) &probeTarget.addr[4]))
+                helpers.push_back(i);
+        }
+        for (int i = 0; i < par->SWIM_INDIRECT_PROBES && i < (int) helpers.size(); i++) {
+            int j = i + rand() % (helpers.size() - i);
+            swap(helpers[i], helpers[j]);
+
+            Address *helper = getAddress(memberNode->memberList[helpers[i]].id, memberNode->memberList[helpers[i]].port);
+            sendSwimMessage(helper, PINGREQ, probeSeq, &probeTarget);
+            delete helper;
+        }
+        probeIndirectSent = true;
+    }
+
+    // Suspects that did not refute in time are confirmed failed
+    vector<unsigned long long> expired;
+    long suspectTimeout = swimSuspectTimeout();
+    for (auto &suspect : suspects) {
+        if (now - suspect.second >= suspectTimeout)
+            expired.push_back(suspect.first);
+    }
+    for (unsigned long long key : expired) {
+        MemberListEntry *entry = checkMemberList((int) (key >> 16), (short) (key & 0xFFFF));
+        if (entry != nullptr)
+            swimConfirm(entry - &memberNode->memberList[0]);
+        else
+            suspects.erase(key);
+    }
+
+    // Start a new protocol period
+    if (probeActive && now - probeTime < SWIM_PERIOD)
+        return;
+
+    if (probeActive && !probeAcked) {
+        MemberListEntry *entry = checkMemberList(&probeTarget);
+        if (entry != nullptr)
+            swimSuspect(entry - &memberNode->memberList[0], entry->heartbeat);
+    }
+
+    // Tell the suspects, whose refutations would otherwise only travel by piggyback
+    for (auto &suspect : suspects) {
+        Address *suspectAddress = getAddress((int) (suspect.first >> 16), (short) (suspect.first & 0xFFFF));
+        sendSwimMessage(suspectAddress, PROBE, -1, &memberNode->addr);
+        delete suspectAddress;
+    }
+
+    probeActive = false;
+    nextProbeTarget();
+    if (!probeActive)
+        return;
+
+    sendSwimMessage(&probeTarget, PROBE, probeSeq, &memberNode->addr);
+}
+
+/**
+ * FUNCTION NAME: swimSuspectTimeout
+ *
+ * DESCRIPTION: Time units a suspect has to refute before it is confirmed failed. A
+ * 				suspicion takes about log(group size) periods to spread, so the timeout
+ * 				grows with the group, as in SWIM
+ */
+long MP1Node::swimSuspectTimeout() {
+    double groupSize = memberNode->memberList.size() + 1;
+
+    return (long) ceil(SWIM_SUSPECT_MULTIPLIER * max(1.0, log10(groupSize)) * SWIM_PERIOD);
+}
+
+/**
+ * FUNCTION NAME: nextProbeTarget
+ *
+ * DESCRIPTION: Pick the member to probe this period, walking a shuffled copy of the
+ * 				membership list round-robin so every member is probed once per pass
+ */
+void MP1Node::nextProbeTarget() {
+    for (int pass = 0; pass < 2; pass++) {
+        while (probeIndex < probeOrder.size()) {
+            unsigned long long key = probeOrder[probeIndex++];
+            MemberListEntry *entry = checkMemberList((int) (key >> 16), (short) (key & 0xFFFF));
+            if (entry == nullptr)
+                continue;
+
+            Address *target = getAddress(entry->id, entry->port);
+            probeTarget = *target;
+            delete target;
+
+            probeActive = true;
+            probeAcked = false;
+            probeIndirectSent = false;
+            probeTime = par->getcurrtime();
+            probeSeq++;
+            return;
+        }
+
+        probeOrder.clear();
+        probeIndex = 0;
+        for (auto &entry : memberNode->memberList)
+            probeOrder.push_back(memberKey(entry.id, entry.port));
+        for (int i = (int) probeOrder.size() - 1; i > 0; i--)
+            swap(probeOrder[i], probeOrder[rand() % (i + 1)]);
+    }
+}
+
+/**
+ * FUNCTION NAME: swimHandler
+ *
+ * DESCRIPTION: Handle a PROBE, ACK or PINGREQ and apply the updates it carries
+ */
+void MP1Node::swimHandler(SwimMessage *msg) {
+    bool refuted = applySwimUpdates(msg);
+    swimHeardFrom(&msg->addr);
+
+    // Refute straight back to whoever told us of the suspicion; a PROBE gets it in its ACK
+    if (refuted && msg->msgType != PROBE)
+        sendSwimMessage(&msg->addr, ACK, -1, &msg->addr);
+
+    switch (msg->msgType) {
+        case PROBE:
+            // Ack to whoever sent the probe, on behalf of its originator
+            sendSwimMessage(&msg->addr, ACK, msg->seq, &msg->subject);
+            break;
+        case ACK:
+            if (msg->subject == memberNode->addr) {
+                if (probeActive && msg->seq == probeSeq)
+                    probeAcked = true;
+            } else {
+                // Indirect probe answered: relay the ack to the originator
+                sendSwimMessage(&msg->subject, ACK, msg->seq, &msg->subject);
+            }
+            break;
+        case PINGREQ:
+            sendSwimMessage(&msg->subject, PROBE, msg->seq, &msg->addr);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * FUNCTION NAME: swimJoinHandler
+ *
+ * DESCRIPTION: In SWIM mode the introducer announces the new member to the group, and
+ * 				the new member adopts the list carried by JOINREP and announces itself
+ */
+void MP1Node::swimJoinHandler(MessageHdr *msg) {
+    if (msg->msgType == JOINREQ) {
+        enqueueSwimUpdate(*(int *) msg->addr.addr, *(short *) &msg->addr.addr[4], SWIM_ALIVE, 0);
+        return;
+    }
+
+    MemberListEntry entry;
+    for (int index = 0; index < msg->memberCount; index++) {
+        decodeMemberEntry(msg, index, &entry);
+        if (checkMemberList(entry.id, entry.port) == nullptr)
+            pushNodeToMembershipList(&entry);
+    }
+    enqueueSwimUpdate(*(int *) memberNode->addr.addr, *(short *) &memberNode->addr.addr[4], SWIM_ALIVE, incarnation);
+}
+
+/**
+ * FUNCTION NAME: swimHeardFrom
+ *
+ * DESCRIPTION: A message came straight from this member: add it if it is unknown and
+ * 				was not confirmed failed
+ */
+void MP1Node::swimHeardFrom(Address *addr) {
+    int id = *(int *) addr->addr;
+    short port = *(short *) &addr->addr[4];
+
+    if (checkMemberList(id, port) != nullptr || deadMembers.count(memberKey(id, port)))
+        return;
+
+    MemberListEntry entry(id, port, 0, par->getcurrtime());
+    pushNodeToMembershipList(&entry);
+}
+
+/**
+ * FUNCTION NAME: swimSuspect
+ *
+ * DESCRIPTION: Mark the member at the given position as suspect and spread the suspicion
+ */
+void MP1Node::swimSuspect(int index, long suspectIncarnation) {
+    MemberListEntry &entry = memberNode->memberList[index];
+    unsigned long long key = memberKey(entry.id, entry.port);
+
+    entry.heartbeat = suspectIncarnation;
+    entry.timestamp = par->getcurrtime();
+    if (!suspects.count(key))
+        suspects[key] = par->getcurrtime();
+
+    enqueueSwimUpdate(entry.id, entry.port, SWIM_SUSPECT, suspectIncarnation);
+}
+
+/**
+ * FUNCTION NAME: swimConfirm
+ *
+ * DESCRIPTION: Remove the member at the given position as failed and spread the news
+ */
+void MP1Node::swimConfirm(int index) {
+    MemberListEntry entry = memberNode->memberList[index];
+    unsigned long long key = memberKey(entry.id, entry.port);
+
+    suspects.erase(key);
+    deadMembers[key] = entry.heartbeat;
+    removeMember(index);
+
+    enqueueSwimUpdate(entry.id, entry.port, SWIM_CONFIRM, entry.heartbeat);
+}
+
+/**
+ * FUNCTION NAME: applySwimUpdates
+ *
+ * DESCRIPTION: Merge the piggybacked updates of a message. Higher incarnations override
+ * 				lower ones, suspicion overrides alive at the same incarnation, and a
+ * 				node refutes a suspicion about itself by bumping its own incarnation.
+ * 				A confirm is final for the incarnation it names and for the refutation
+ * 				of that suspicion: a node that hears it was confirmed rejoins with an
+ * 				incarnation past both, and only that brings it back.
+ *
+ * RETURNS:
+ * true if the message suspected or confirmed this node and it refuted
+ */
+bool MP1Node::applySwimUpdates(SwimMessage *msg) {
+    bool refuted = false;
+
+    for (int index = 0; index < msg->updateCount; index++) {
+        const char *ptr = msg->updates + index * SWIM_UPDATE_SIZE;
+        int id;
+        short port;
+        int updateIncarnation;
+
+        memcpy(&id, ptr, sizeof(int));
+        memcpy(&port, ptr + 4, sizeof(short));
+        auto type = (SwimUpdateTypes) ptr[6];
+        memcpy(&updateIncarnation, ptr + 7, sizeof(int));
+
+        unsigned long long key = memberKey(id, port);
+        if (key == memberKey(*(int *) memberNode->addr.addr, *(short *) &memberNode->addr.addr[4])) {
+            // A suspicion older than our incarnation was refuted already, but the
+            // suspector may have missed it, so the refutation is repeated
+            if (type == SWIM_SUSPECT) {
+                incarnation = max(incarnation, (long) updateIncarnation + 1);
+                enqueueSwimUpdate(id, port, SWIM_ALIVE, incarnation);
+                refuted = true;
+            }
+            if (type == SWIM_CONFIRM && updateIncarnation + 2 > incarnation) {
+                incarnation = updateIncarnation + 2;
+                enqueueSwimUpdate(id, port, SWIM_ALIVE, incarnation);
+                refuted = true;
+            }
+            continue;
+        }
+
+        MemberListEntry *entry = checkMemberList(id, port);
+        auto dead = deadMembers.find(key);
+
+        switch (type) {
+            case SWIM_ALIVE:
+                if (entry == nullptr) {
+                    if (dead != deadMembers.end() && updateIncarnation <= dead->second + 1)
+                        break;
+                    deadMembers.erase(key);
+                    MemberListEntry newEntry(id, port, updateIncarnation, par->getcurrtime());
+                    pushNodeToMembershipList(&newEntry);
+                    enqueueSwimUpdate(id, port, SWIM_ALIVE, updateIncarnation);
+                } else if (updateIncarnation > entry->heartbeat) {
+                    entry->heartbeat = updateIncarnation;
+                    entry->timestamp = par->getcurrtime();
+                    suspects.erase(key);
+                    enqueueSwimUpdate(id, port, SWIM_ALIVE, updateIncarnation);
+                }
+                break;
+            case SWIM_SUSPECT:
+                if (entry == nullptr)
+                    break;
+                if (updateIncarnation > entry->heartbeat || (updateIncarnation == entry->heartbeat && !suspects.count(key)))
+                    swimSuspect(entry - &memberNode->memberList[0], updateIncarnation);
+                break;
+            case SWIM_CONFIRM:
+                // A confirm older than a refutation we already heard is stale
+                if (entry == nullptr || updateIncarnation < entry->heartbeat)
+                    break;
+                entry->heartbeat = updateIncarnation;
+                swimConfirm(entry - &memberNode->memberList[0]);
+                break;
+        }
+    }
+
+    return refuted;
+}
+
+/**
+ * FUNCTION NAME: enqueueSwimUpdate
+ *
+ * DESCRIPTION: Queue an update for dissemination, replacing any older one about the same member
+ */
+void MP1Node::enqueueSwimUpdate(int id, short port, SwimUpdateTypes type, long updateIncarnation) {
+    int transmissions = SWIM_LAMBDA * (int) ceil(log2(memberNode->memberList.size() + 2));
+
+    for (auto &update : swimUpdates) {
+        if (update.id == id && update.port == port) {
+            update.type = type;
+            update.incarnation = updateIncarnation;
+            update.transmissions = transmissions;
+            return;
+        }
+    }
+
+    SwimUpdate update = { id, port, type, updateIncarnation, transmissions };
+    swimUpdates.push_back(update);
+}
+
+/**
+ * FUNCTION NAME: sendSwimMessage
+ *
+ * DESCRIPTION: Encode a SWIM message straight into a send buffer, piggybacking as many
+ * 				pending updates as fit
+ */
+void MP1Node::sendSwimMessage(Address *addressDestino, MsgTypes msgType, int seq, Address *subject) {
+    int capacity = min(SWIM_HEADER_SIZE + (int) swimUpdates.size() * SWIM_UPDATE_SIZE, emulNet->ENmaxPayload());
+    char *buffer = emulNet->ENbuffer(capacity);
+    unsigned short count = min((capacity - SWIM_HEADER_SIZE) / SWIM_UPDATE_SIZE, (int) swimUpdates.size());
+    char *ptr = buffer;
+
+    *ptr++ = (char) msgType;
+    memcpy(ptr, memberNode->addr.addr, sizeof(memberNode->addr.addr));
+    ptr += sizeof(memberNode->addr.addr);
+    memcpy(ptr, &seq, sizeof(int));
+    ptr += sizeof(int);
+    memcpy(ptr, subject->addr, sizeof(subject->addr));
+    ptr += sizeof(subject->addr);
+    memcpy(ptr, &count, sizeof(unsigned short));
+    ptr += sizeof(unsigned short);
+
+    for (int i = 0; i < count; i++) {
+        SwimUpdate &update = swimUpdates[i];
+        int updateIncarnation = (int) update.incarnation;
+
+        memcpy(ptr, &update.id, sizeof(int));
+        memcpy(ptr + 4, &update.port, sizeof(short));
+        ptr[6] = (char) update.type;
+        memcpy(ptr + 7, &updateIncarnation, sizeof(int));
+        ptr += SWIM_UPDATE_SIZE;
+
+        update.transmissions--;
+    }
+
+    // Retire the updates that were piggybacked often enough, oldest first
+    swimUpdates.erase(remove_if(swimUpdates.begin(), swimUpdates.end(),
+                                [](const SwimUpdate &update) { return update.transmissions <= 0; }),
+                      swimUpdates.end());
+
+    emulNet->ENsendBuffer(&memberNode->addr, addressDestino, buffer, (int) (ptr - buffer));
+}
+
+/**
+ * FUNCTION NAME: decodeSwimMessage
+ *
+ * DESCRIPTION: Decode the header of a SWIM message without copying its updates
+ *
+ * RETURNS:
+ * false if the message is truncated
+ */
+bool MP1Node::decodeSwimMessage(char *data, int size, SwimMessage *msg) {
+    unsigned short count;
+
+    if (size < SWIM_HEADER_SIZE)
+        return false;
+
+    msg->msgType = (MsgTypes) data[0];
+    memcpy(msg->addr.addr, data + 1, sizeof(msg->addr.addr));
+    memcpy(&msg->seq, data + 7, sizeof(int));
+    memcpy(msg->subject.addr, data + 11, sizeof(msg->subject.addr));
+    memcpy(&count, data + 17, sizeof(unsigned short));
+
+    if (size < SWIM_HEADER_SIZE + count * SWIM_UPDATE_SIZE)
+        return false;
+
+    msg->updateCount = count;
+    msg->updates = data + SWIM_HEADER_SIZE;
+    return true;
+}
+
 /**
  * FUNCTION NAME: isNullAddress
  *
@@ -397,6 +1189,8 @@ Address MP1Node::getJoinAddress() {
  */
 void MP1Node::initMemberListTable(Member *memberNode) {
     memberNode->memberList.clear();
+    memberNode->memberEvents.clear();
+    memberIndex.clear();
 }
 
 /**
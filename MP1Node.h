@@ -14,12 +14,27 @@
 #include "Member.h"
 #include "EmulNet.h"
 #include "Queue.h"
+#include "HashIndex.h"
+#include "TimerWheel.h"
 
 /**
  * Macros
  */
 #define TREMOVE 20
 #define TFAIL 5
+// SWIM detector timing, in time units
+#define SWIM_PERIOD 6
+#define SWIM_PROBE_TIMEOUT 2
+// A suspect is confirmed after SWIM_SUSPECT_MULTIPLIER * log10(group size) protocol periods
+// (at least SWIM_SUSPECT_MULTIPLIER), which gives it time to hear of the suspicion and refute
+#define SWIM_SUSPECT_MULTIPLIER 4
+// An update is piggybacked SWIM_LAMBDA * log2(group size) times
+#define SWIM_LAMBDA 3
+// Phi-accrual detector: heartbeat inter-arrival times kept per member, samples needed
+// before phi is trusted over TREMOVE, and floor on the inter-arrival deviation
+#define PHI_WINDOW_SIZE 16
+#define PHI_MIN_SAMPLES 4
+#define PHI_MIN_STDDEV 1.0
 
 /*
  * Note: You can change/add any functions in MP1Node.{h,cpp}
@@ -32,20 +47,111 @@ enum MsgTypes{
     JOINREQ,
     JOINREP,
     DUMMYLASTMSGTYPE,
-    PING
+    PING,
+    PROBE,
+    ACK,
+    PINGREQ
 };
 
+/**
+ * Kinds of membership updates disseminated by the SWIM detector
+ */
+enum SwimUpdateTypes{
+    SWIM_ALIVE,
+    SWIM_SUSPECT,
+    SWIM_CONFIRM
+};
+
+/**
+ * Wire format of a membership message:
+ * 		msgType		1 byte
+ * 		sender		6 bytes (Address)
+ * 		heartbeat	4 bytes, the sender's own heartbeat
+ * 		count		2 bytes, number of member entries that follow
+ * 		entries		count * MP1_ENTRY_SIZE bytes, each one
+ * 					id (4) | port (2) | heartbeat (4) | age (2)
+ * Multi-byte fields are in host byte order. The age is the number of time units
+ * since the sender last refreshed the entry, so no clock is shared.
+ */
+#define MP1_HEADER_SIZE 13
+#define MP1_ENTRY_SIZE 12
+#define MP1_MAX_AGE 0xFFFF
+
 /**
  * STRUCT NAME: MessageHdr
  *
- * DESCRIPTION: Header and content of a message
+ * DESCRIPTION: Decoded view of a message. The member entries are left packed in
+ * 				the receive buffer and decoded one at a time with decodeMemberEntry
  */
 typedef struct MessageHdr {
 	enum MsgTypes msgType;
-	Address *addr;
-	vector<MemberListEntry> memberVector;
+	Address addr;
+	long heartbeat;
+	int memberCount;
+	const char *members;
 }MessageHdr;
 
+/**
+ * Wire format of a SWIM message (PROBE, ACK, PINGREQ):
+ * 		msgType		1 byte
+ * 		sender		6 bytes (Address)
+ * 		seq			4 bytes, probe sequence number of the originator
+ * 		subject		6 bytes, originator of a PROBE/ACK, target of a PINGREQ
+ * 		count		2 bytes, number of piggybacked updates that follow
+ * 		updates		count * SWIM_UPDATE_SIZE bytes, each one
+ * 					id (4) | port (2) | type (1) | incarnation (4)
+ */
+#define SWIM_HEADER_SIZE 19
+#define SWIM_UPDATE_SIZE 11
+
+/**
+ * STRUCT NAME: SwimMessage
+ *
+ * DESCRIPTION: Decoded view of a SWIM message, updates left packed in the receive buffer
+ */
+typedef struct SwimMessage {
+	enum MsgTypes msgType;
+	Address addr;
+	int seq;
+	Address subject;
+	int updateCount;
+	const char *updates;
+}SwimMessage;
+
+/**
+ * STRUCT NAME: SwimUpdate
+ *
+ * DESCRIPTION: Membership update waiting in the dissemination buffer
+ */
+typedef struct SwimUpdate {
+	int id;
+	short port;
+	enum SwimUpdateTypes type;
+	long incarnation;
+	int transmissions;
+}SwimUpdate;
+
+/**
+ * STRUCT NAME: PhiWindow
+ *
+ * DESCRIPTION: Last PHI_WINDOW_SIZE heartbeat inter-arrival times of a member
+ */
+typedef struct PhiWindow {
+	long intervals[PHI_WINDOW_SIZE];
+	int count;
+	int next;
+}PhiWindow;
+
+/**
+ * STRUCT NAME: MemberRemoval
+ *
+ * DESCRIPTION: A member this node removed from its list, and when
+ */
+typedef struct MemberRemoval {
+	Address addr;
+	long time;
+}MemberRemoval;
+
 /**
  * CLASS NAME: MP1Node
  *
@@ -58,12 +164,58 @@ private:
 	Params *par;
 	Member *memberNode;
 	char NULLADDR[6];
+	// Position of each member in memberNode->memberList, keyed by memberKey
+	HashIndex memberIndex;
+	// TREMOVE expiry timer of each member, keyed by memberKey. A heartbeat refresh
+	// does not move the timer: when it fires early it is re-armed from the timestamp.
+	TimerWheel expiryWheel;
+	HashIndex expiryTimers;
+	// Heartbeat of each member as of the last gossip round that carried it
+	unordered_map<unsigned long long, long> gossipedHeartbeats;
+	// Members whose current heartbeat came from the member itself rather than through gossip
+	unordered_set<unsigned long long> ownerHeartbeats;
+	// Number of gossip rounds run so far
+	long gossipRound;
+	// Phi-accrual detector only: time members were removed at, so gossip older than that
+	// does not bring them back. Phi removes a member before its entry is TREMOVE old, so
+	// that gossip would still pass the age check; past TREMOVE the age check rejects it,
+	// and the tombstone is dropped when its removedWheel timer fires.
+	unordered_map<unsigned long long, long> removedMembers;
+	TimerWheel removedWheel;
+	// Every removal made by this node, for detector statistics
+	vector<MemberRemoval> removals;
+	// Phi-accrual detector: inter-arrival history of each member, and the distance
+	// from the mean, in standard deviations, at which phi reaches PHI_THRESHOLD
+	unordered_map<unsigned long long, PhiWindow> phiWindows;
+	double phiCrossing;
+	// SWIM detector: own incarnation number
+	long incarnation;
+	// SWIM detector: probe of the current protocol period
+	int probeSeq;
+	Address probeTarget;
+	bool probeActive;
+	bool probeAcked;
+	bool probeIndirectSent;
+	long probeTime;
+	// SWIM detector: round-robin probing order
+	vector<unsigned long long> probeOrder;
+	unsigned int probeIndex;
+	// SWIM detector: suspected members and the time they became suspect
+	unordered_map<unsigned long long, long> suspects;
+	// SWIM detector: incarnation at which members were confirmed failed. Only an
+	// announcement from a later incarnation than that confirm's refutation revives them
+	unordered_map<unsigned long long, long> deadMembers;
+	// SWIM detector: dissemination buffer
+	vector<SwimUpdate> swimUpdates;
 
 public:
 	MP1Node(Member *, Params *, EmulNet *, Log *, Address *);
 	Member * getMemberNode() {
 		return memberNode;
 	}
+	const vector<MemberRemoval> &getRemovals() {
+		return removals;
+	}
 	int recvLoop();
 	static int enqueueWrapper(void *env, char *buff, int size);
 	void nodeStart(char *servaddrstr, short serverport);
@@ -75,13 +227,38 @@ public:
 	bool recvCallBack(void *env, char *data, int size);
     void pushNodeToMembershipList(MessageHdr *msg);
     void pushNodeToMembershipList(MemberListEntry *entry);
+    void addMember(int id, short port, long heartbeat, long timestamp);
     void pingHandler(MessageHdr *msgReceived);
     void updateSrcMember(MessageHdr *msgReceived);
     MemberListEntry* checkMemberList(int id, short port);
     MemberListEntry* checkMemberList(Address *nodeAddress);
     void sendMessage(Address *addressDestino, MsgTypes msgType);
+    void sendMessage(Address *addressDestino, MsgTypes msgType, vector<int> &entries);
+    int encodeMessage(char *buffer, int capacity, MsgTypes msgType, vector<int> &entries);
+    static unsigned long long memberKey(int id, short port);
+    bool decodeMessage(char *data, int size, MessageHdr *msg);
+    void decodeMemberEntry(MessageHdr *msg, int index, MemberListEntry *entry);
     Address* getAddress(int id, short port);
 	void nodeLoopOps();
+	void removeMember(int index);
+	void expireMembers();
+	void refreshMember(MemberListEntry *entry);
+	long expiryTime(MemberListEntry *entry);
+	static double phiCrossingPoint(double threshold);
+	void swimLoopOps();
+	void swimHandler(SwimMessage *msg);
+	long swimSuspectTimeout();
+	void swimJoinHandler(MessageHdr *msg);
+	void swimHeardFrom(Address *addr);
+	void swimSuspect(int index, long incarnation);
+	void swimConfirm(int index);
+	void nextProbeTarget();
+	void enqueueSwimUpdate(int id, short port, SwimUpdateTypes type, long incarnation);
+	bool applySwimUpdates(SwimMessage *msg);
+	void sendSwimMessage(Address *addressDestino, MsgTypes msgType, int seq, Address *subject);
+	bool decodeSwimMessage(char *data, int size, SwimMessage *msg);
+	void selectGossipTargets(vector<int> &targets);
+	void selectGossipEntries(vector<int> &entries);
 	int isNullAddress(Address *addr);
 	Address getJoinAddress();
 	void initMemberListTable(Member *memberNode);
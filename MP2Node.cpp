@@ -9,21 +9,34 @@
 
 /**
  * constructor
+ *
+ * DESCRIPTION: A node restarted after a failure rebuilds its hash table from its write-ahead
+ * 				log; any other node starts the log afresh, so nothing of an earlier run is replayed
  */
-MP2Node::MP2Node(Member *memberNode, Params *par, EmulNet *emulNet, Log *log, Address *address) {
+MP2Node::MP2Node(Member *memberNode, Params *par, EmulNet *emulNet, Log *log, Address *address, bool restarted) {
     this->memberNode = memberNode;
     this->par = par;
     this->emulNet = emulNet;
     this->log = log;
     this->ht = new HashTable();
     this->memberNode->addr = *address;
-    this->transactionsMap = new map<int, Transaction *>;
+    this->transactionTimeouts = TimerWheel(64, par->getcurrtime());
+    this->wal = NULL;
+    this->walCheckpointSize = 0;
+    if (par->WAL) {
+        string path = this->memberNode->addr.getAddress();
+        replace(path.begin(), path.end(), ':', '_');
+        this->wal = new WriteAheadLog(WAL_FILE_PREFIX + path + ".log", !restarted);
+        if (restarted)
+            this->recoverFromWal();
+    }
 }
 
 /**
  * Destructor
  */
 MP2Node::~MP2Node() {
+    delete wal;
     delete ht;
     delete memberNode;
 }
@@ -34,42 +47,175 @@ Transaction::Transaction(int id, int timestamp, MessageType msgType, string key,
     this->msgType = msgType;
     this->key = move(key);
     this->value = move(value);
+    this->replyCount = 0;
+    this->successCount = 0;
+    this->replicaCount = 0;
+    this->requiredCount = 0;
+    this->timer = -1;
 }
 
 /**
  * FUNCTION NAME: updateRing
  *
  * DESCRIPTION: This function does the following:
- * 				1) Gets the current membership list from the Membership Protocol (MP1Node)
- * 				   The membership list is returned as a vector of Nodes. See Node class in Node.h
- * 				2) Constructs the ring based on the membership list
- * 				3) Calls the Stabilization Protocol
+ * 				1) Builds the ring from the membership list the first time it runs
+ * 				2) Afterwards, applies the joins and leaves the Membership Protocol (MP1Node)
+ * 				   published since the last call as insertions and removals in the sorted ring
+ * 				3) Calls the Stabilization Protocol with the nodes that joined and left
  */
 void MP2Node::updateRing() {
-
-    vector<Node> curMemList;
+    vector<MemberEvent> &events = this->memberNode->memberEvents;
+    vector<Node> joined;
+    vector<Node> left;
 
     /*
-     *  Step 1. Get the current membership list from Membership Protocol / MP1
+     * Step 1: Build the ring once; it always holds this node afterwards
      */
-    curMemList = getMembershipList();
-    curMemList.emplace_back(this->memberNode->addr);
+    if (this->ring.empty()) {
+        this->ring = getMembershipList();
+        this->ring.emplace_back(this->memberNode->addr);
+        sort(this->ring.begin(), this->ring.end());
+        this->buildRingIndex(this->ring, this->ringHashes, this->ringSuccessors);
+        events.clear();
+        return;
+    }
 
     /*
-     * Step 2: Construct the ring
+     * Step 2: Apply the membership changes
      */
-    // Sort the list based on the hashCode
-    sort(curMemList.begin(), curMemList.end());
+    for (auto &event : events) {
+        Node node(event.addr);
+        if (event.joined && this->insertRingNode(node))
+            joined.push_back(node);
+        if (!event.joined && this->removeRingNode(node))
+            left.push_back(node);
+    }
+    events.clear();
+
+    // A node that left and rejoined (or joined and left) within the batch did not change the ring
+    for (int i = joined.size() - 1; i >= 0; i--) {
+        for (int j = left.size() - 1; j >= 0; j--) {
+            if (*joined[i].getAddress() == *left[j].getAddress()) {
+                joined.erase(joined.begin() + i);
+                left.erase(left.begin() + j);
+                break;
+            }
+        }
+    }
+
+    if (joined.empty() && left.empty())
+        return;
+
+    this->buildRingIndex(this->ring, this->ringHashes, this->ringSuccessors);
 
     /*
-     * Step 3: Run the stabilization protocol IF REQUIRED
+     * Step 3: Run the stabilization protocol if this node holds keys
      */
-    // Run stabilization protocol if the hash table size is greater than zero and if there has been a changed in the ring
-    bool change = curMemList.size() != this->ring.size();
-    this->ring = curMemList;
+    if (this->ht->currentSize() > 0)
+        this->stabilizationProtocol(joined, left);
+}
+
+/**
+ * FUNCTION NAME: insertRingNode
+ *
+ * DESCRIPTION: Insert a node at its position in the sorted ring
+ *
+ * RETURNS:
+ * false if the node was already in the ring
+ */
+bool MP2Node::insertRingNode(Node &node) {
+    auto range = equal_range(this->ring.begin(), this->ring.end(), node);
+
+    for (auto it = range.first; it != range.second; it++) {
+        if (*it->getAddress() == *node.getAddress())
+            return false;
+    }
+
+    this->ring.insert(range.second, node);
+    return true;
+}
+
+/**
+ * FUNCTION NAME: removeRingNode
+ *
+ * DESCRIPTION: Remove a node from the sorted ring
+ *
+ * RETURNS:
+ * false if the node was not in the ring
+ */
+bool MP2Node::removeRingNode(Node &node) {
+    auto range = equal_range(this->ring.begin(), this->ring.end(), node);
+
+    for (auto it = range.first; it != range.second; it++) {
+        if (*it->getAddress() == *node.getAddress()) {
+            this->ring.erase(it);
+            return true;
+        }
+    }
+
+    return false;
+}
 
-    if (this->ht->currentSize() > 0 && change)
-        this->stabilizationProtocol();
+/**
+ * FUNCTION NAME: buildRingIndex
+ *
+ * DESCRIPTION: Build the token table: every ring node is placed at VNODES positions, laid
+ * 				out sorted and contiguous. For each token, precompute the replicas of the
+ * 				keys it owns: the first Params::REPLICATION_FACTOR distinct nodes met walking the
+ * 				tokens clockwise from it.
+ */
+void MP2Node::buildRingIndex(vector<Node> &nodes, vector<unsigned long long> &hashes, vector<int> &successorTable) {
+    int ringSize = nodes.size();
+    int replicationFactor = this->par->REPLICATION_FACTOR;
+    vector<pair<unsigned long long, int>> tokens;
+
+    for (int i = 0; i < ringSize; i++) {
+        for (int token = 0; token < this->par->VNODES; token++)
+            tokens.emplace_back(nodes[i].getTokenHashCode(token), i);
+    }
+    sort(tokens.begin(), tokens.end());
+
+    int tokenCount = tokens.size();
+    hashes.resize(tokenCount);
+    for (int t = 0; t < tokenCount; t++)
+        hashes[t] = tokens[t].first;
+
+    successorTable.clear();
+    if (ringSize < replicationFactor)
+        return;
+
+    successorTable.resize(tokenCount * replicationFactor);
+    for (int t = 0; t < tokenCount; t++) {
+        int *successors = &successorTable[t * replicationFactor];
+        int found = 0;
+
+        for (int step = 0; found < replicationFactor; step++) {
+            int node = tokens[(t + step) % tokenCount].second;
+            if (find(successors, successors + found, node) == successors + found)
+                successors[found++] = node;
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: findReplicas
+ *
+ * DESCRIPTION: Look up the replicas of a ring position in a token table built by buildRingIndex
+ *
+ * RETURNS:
+ * the Params::REPLICATION_FACTOR ring node indices holding the position, NULL if the ring is too small
+ */
+const int *MP2Node::findReplicas(unsigned long long pos, const vector<unsigned long long> &hashes,
+                                 const vector<int> &successorTable) {
+    if (successorTable.empty())
+        return NULL;
+
+    // The owner is the first token at or after pos, wrapping around to the first token
+    int owner = lower_bound(hashes.begin(), hashes.end(), pos) - hashes.begin();
+    if (owner == (int) hashes.size())
+        owner = 0;
+
+    return &successorTable[owner * this->par->REPLICATION_FACTOR];
 }
 
 /**
@@ -103,12 +249,10 @@ vector<Node> MP2Node::getMembershipList() {
  * 				HASH FUNCTION USED FOR CONSISTENT HASHING
  *
  * RETURNS:
- * size_t position on the ring
+ * 64-bit position on the ring
  */
-size_t MP2Node::hashFunction(string key) {
-    std::hash<string> hashFunc;
-    size_t ret = hashFunc(key);
-    return ret % RING_SIZE;
+unsigned long long MP2Node::hashFunction(StringView key) {
+    return ringHash(key.data(), key.size());
 }
 
 /**
@@ -119,9 +263,10 @@ size_t MP2Node::hashFunction(string key) {
  * 				1) Constructs the message
  * 				2) Finds the replicas of this key
  * 				3) Sends a message to the replica
+ * 				The operation completes once the replies asked for by level arrive
  */
-void MP2Node::clientCreate(string key, string value) {
-    this->clientPerformOperation(MessageType::CREATE, move(key), move(value));
+void MP2Node::clientCreate(string key, string value, ConsistencyLevel level) {
+    this->clientPerformOperation(MessageType::CREATE, level, move(key), move(value));
 }
 
 /**
@@ -132,9 +277,10 @@ void MP2Node::clientCreate(string key, string value) {
  * 				1) Constructs the message
  * 				2) Finds the replicas of this key
  * 				3) Sends a message to the replica
+ * 				The operation completes once the replies asked for by level arrive
  */
-void MP2Node::clientRead(string key) {
-    this->clientPerformOperation(MessageType::READ, move(key));
+void MP2Node::clientRead(string key, ConsistencyLevel level) {
+    this->clientPerformOperation(MessageType::READ, level, move(key));
 }
 
 /**
@@ -145,9 +291,10 @@ void MP2Node::clientRead(string key) {
  * 				1) Constructs the message
  * 				2) Finds the replicas of this key
  * 				3) Sends a message to the replica
+ * 				The operation completes once the replies asked for by level arrive
  */
-void MP2Node::clientUpdate(string key, string value) {
-    this->clientPerformOperation(MessageType::UPDATE, move(key), move(value));
+void MP2Node::clientUpdate(string key, string value, ConsistencyLevel level) {
+    this->clientPerformOperation(MessageType::UPDATE, level, move(key), move(value));
 }
 
 /**
@@ -158,36 +305,155 @@ void MP2Node::clientUpdate(string key, string value) {
  * 				1) Constructs the message
  * 				2) Finds the replicas of this key
  * 				3) Sends a message to the replica
+ * 				The operation completes once the replies asked for by level arrive
  */
-void MP2Node::clientDelete(string key) {
-    this->clientPerformOperation(MessageType::DELETE, move(key));
+void MP2Node::clientDelete(string key, ConsistencyLevel level) {
+    this->clientPerformOperation(MessageType::DELETE, level, move(key));
 }
 
-void MP2Node::clientPerformOperation(MessageType msgType, string key, string value) {
-    int transactionId = g_transID++;
-    Address address = this->memberNode->addr;
+/**
+ * FUNCTION NAME: multiGet
+ *
+ * DESCRIPTION: client side READ API for many keys
+ * 				Every key is read as by clientRead, but each replica gets a single batch
+ */
+void MP2Node::multiGet(const vector<string> &keys, ConsistencyLevel level) {
+    vector<pair<string, string>> operations;
 
-    // 1. Message Construction
-    Message *msg = new Message(transactionId, address, msgType, key, value);
+    for (auto &key : keys)
+        operations.emplace_back(key, "");
+    this->clientPerformBatch(MessageType::READ, level, operations);
+}
 
-    string msgData = msg->toString();
+/**
+ * FUNCTION NAME: multiPut
+ *
+ * DESCRIPTION: client side CREATE API for many key value pairs
+ * 				Every pair is created as by clientCreate, but each replica gets a single batch
+ */
+void MP2Node::multiPut(const map<string, string> &keyValues, ConsistencyLevel level) {
+    vector<pair<string, string>> operations(keyValues.begin(), keyValues.end());
+
+    this->clientPerformBatch(MessageType::CREATE, level, operations);
+}
+
+/**
+ * FUNCTION NAME: multiDelete
+ *
+ * DESCRIPTION: client side DELETE API for many keys
+ * 				Every key is deleted as by clientDelete, but each replica gets a single batch
+ */
+void MP2Node::multiDelete(const vector<string> &keys, ConsistencyLevel level) {
+    vector<pair<string, string>> operations;
 
-    // 2. Find Replicas
+    for (auto &key : keys)
+        operations.emplace_back(key, "");
+    this->clientPerformBatch(MessageType::DELETE, level, operations);
+}
+
+void MP2Node::clientPerformOperation(MessageType msgType, ConsistencyLevel level, string key, string value) {
+    // 1. Find Replicas
     vector<Node> replicas = this->findNodes(key);
 
-    // 3. Send message to replicas
-    for (auto &replica : replicas) {
-        int currentTimestamp = this->par->getcurrtime();
+    // 2. Track the operation until enough replicas answer or it times out
+    int transactionId = this->beginTransaction(msgType, level, key, value, replicas.size());
+
+    // 3. Message Construction, stamped with the version of the value it writes
+    Message msg(transactionId, this->memberNode->addr, msgType, key, value);
+    msg.timestamp = this->par->getcurrtime();
+
+    // 4. Send message to replicas
+    for (int replica = 0; replica < (int) replicas.size(); replica++) {
+        msg.replica = this->replicaType(replica);
+        this->sendMessage(replicas[replica].getAddress(), msg);
+    }
+}
 
-        Transaction *transaction = new Transaction(transactionId, currentTimestamp, msgType, key, value);
+/**
+ * FUNCTION NAME: clientPerformBatch
+ *
+ * DESCRIPTION: Start one operation per key, like clientPerformOperation, but group the messages
+ * 				by replica so that every replica gets a single batch
+ */
+void MP2Node::clientPerformBatch(MessageType msgType, ConsistencyLevel level,
+                                 const vector<pair<string, string>> &operations) {
+    // Messages for each replica, keyed by its address
+    map<string, pair<Address, vector<Message>>> batches;
+
+    for (auto &operation : operations) {
+        vector<Node> replicas = this->findNodes(operation.first);
+        int transactionId = this->beginTransaction(msgType, level, operation.first, operation.second,
+                                                   replicas.size());
+        Message msg(transactionId, this->memberNode->addr, msgType, operation.first, operation.second);
+        msg.timestamp = this->par->getcurrtime();
+
+        for (int replica = 0; replica < (int) replicas.size(); replica++) {
+            auto &batch = batches[replicas[replica].getAddress()->getAddress()];
+            batch.first = *replicas[replica].getAddress();
+            msg.replica = this->replicaType(replica);
+            batch.second.push_back(msg);
+        }
+    }
 
-        this->transactionsMap->emplace(transactionId, transaction);
+    for (auto &batch : batches)
+        this->sendBatch(&batch.second.first, MessageType::BATCH, batch.second.second);
+}
 
-        Address *fromAddress = &address;
-        Address *toAddress = replica.getAddress();
+/**
+ * FUNCTION NAME: beginTransaction
+ *
+ * DESCRIPTION: Register a coordinator transaction sent to replicaCount replicas
+ *
+ * RETURNS:
+ * its transaction id
+ */
+int MP2Node::beginTransaction(MessageType msgType, ConsistencyLevel level, const string &key, const string &value,
+                              int replicaCount) {
+    int transactionId = g_transID++;
+    int currentTimestamp = this->par->getcurrtime();
+    int slot;
 
-        this->emulNet->ENsend(fromAddress, toAddress, msgData);
+    if (this->freeTransactions.empty()) {
+        slot = this->transactions.size();
+        this->transactions.emplace_back(transactionId, currentTimestamp, msgType, key, value);
+    } else {
+        slot = this->freeTransactions.back();
+        this->freeTransactions.pop_back();
+        this->transactions[slot] = Transaction(transactionId, currentTimestamp, msgType, key, value);
     }
+    this->transactions[slot].replicaCount = replicaCount;
+    this->transactions[slot].requiredCount = this->requiredReplies(level, replicaCount);
+    this->transactions[slot].timer = this->transactionTimeouts.schedule(transactionId,
+                                                                        currentTimestamp + TRANSACTION_TIMEOUT + 1);
+    this->transactionIndex.insert(transactionId, slot);
+
+    return transactionId;
+}
+
+/**
+ * FUNCTION NAME: replicaType
+ *
+ * DESCRIPTION: Replica type of the node at a position in the replica list of a key; positions
+ * 				past the third all count as TERTIARY
+ */
+ReplicaType MP2Node::replicaType(int position) {
+    return position < TERTIARY ? (ReplicaType) position : TERTIARY;
+}
+
+/**
+ * FUNCTION NAME: requiredReplies
+ *
+ * DESCRIPTION: Number of successful replies an operation sent to replicaCount replicas needs
+ * 				at the given consistency level
+ */
+int MP2Node::requiredReplies(ConsistencyLevel level, int replicaCount) {
+    if (level == ONE)
+        return 1;
+
+    if (level == ALL)
+        return replicaCount;
+
+    return replicaCount / 2 + 1;
 }
 
 /**
@@ -198,13 +464,14 @@ void MP2Node::clientPerformOperation(MessageType msgType, string key, string val
  * 			   	1) Inserts key value into the local hash table
  * 			   	2) Return true or false based on success or failure
  */
-bool MP2Node::createKeyValue(string key, string value, ReplicaType replica, int transId) {
-    // Insert key, value, replicaType into the hash table
-    bool createSuccess = this->ht->create(key, value);
+bool MP2Node::createKeyValue(StringView key, StringView value, ReplicaType replica, int transId, int timestamp) {
+    // Insert key, value, replicaType into the hash table. A write that loses to the stored
+    // version is not applied, so it is neither logged to the WAL nor acknowledged
+    bool createSuccess = this->ht->create(key, value, timestamp, replica) == WRITE_APPLIED;
+    if (createSuccess)
+        this->appendPutToWal(key, value, timestamp, replica);
 
-    Transaction *wrapperTransaction = new Transaction(transId, -1, MessageType::CREATE, key, value);
-
-    this->logOperationNonCoordinator(wrapperTransaction, createSuccess);
+    this->logOperationNonCoordinator(MessageType::CREATE, transId, key, value, createSuccess);
 
     return createSuccess;
 }
@@ -215,18 +482,18 @@ bool MP2Node::createKeyValue(string key, string value, ReplicaType replica, int
  * DESCRIPTION: Server side READ API
  * 			    This function does the following:
  * 			    1) Read key from local hash table
- * 			    2) Return value
+ * 			    2) Return a view of the stored value, empty if the key is not found
  */
-string MP2Node::readKey(string key, int transId) {
+StringView MP2Node::readKey(StringView key, int transId) {
     // Read key from local hash table and return value
-    string value = this->ht->read(key);
-    bool readSuccess = !value.empty();
-
-    Transaction *wrapperTransaction = new Transaction(transId, -1, MessageType::READ, key, value);
+    EntryView entry;
+    bool readSuccess = this->ht->find(key, &entry) && !entry.value.empty();
 
-    this->logOperationNonCoordinator(wrapperTransaction, readSuccess);
+    if (!readSuccess)
+        entry.value = StringView();
+    this->logOperationNonCoordinator(MessageType::READ, transId, key, entry.value, readSuccess);
 
-    return value;
+    return entry.value;
 }
 
 /**
@@ -237,13 +504,14 @@ string MP2Node::readKey(string key, int transId) {
  * 				1) Update the key to the new value in the local hash table
  * 				2) Return true or false based on success or failure
  */
-bool MP2Node::updateKeyValue(string key, string value, ReplicaType replica, int transId) {
-    // Update key in local hash table and return true or false
-    bool updateSuccess = this->ht->update(key, value);
+bool MP2Node::updateKeyValue(StringView key, StringView value, ReplicaType replica, int transId, int timestamp) {
+    // Update key in local hash table and return true or false; a write that loses to the
+    // stored version is not applied, logged to the WAL nor acknowledged
+    bool updateSuccess = this->ht->update(key, value, timestamp, replica) == WRITE_APPLIED;
+    if (updateSuccess)
+        this->appendPutToWal(key, value, timestamp, replica);
 
-    Transaction *wrapperTransaction = new Transaction(transId, -1, MessageType::UPDATE, key, value);
-
-    this->logOperationNonCoordinator(wrapperTransaction, updateSuccess);
+    this->logOperationNonCoordinator(MessageType::UPDATE, transId, key, value, updateSuccess);
 
     return updateSuccess;
 }
@@ -256,17 +524,76 @@ bool MP2Node::updateKeyValue(string key, string value, ReplicaType replica, int
  * 				1) Delete the key from the local hash table
  * 				2) Return true or false based on success or failure
  */
-bool MP2Node::deletekey(string key, int transId) {
+bool MP2Node::deletekey(StringView key, int transId) {
     // Delete the key from the local hash table
     bool deleteSuccess = this->ht->deleteKey(key);
+    if (deleteSuccess && this->wal != NULL)
+        this->wal->appendDelete(key);
 
-    Transaction *wrapperTransaction = new Transaction(transId, -1, MessageType::DELETE, key);
-
-    this->logOperationNonCoordinator(wrapperTransaction, deleteSuccess);
+    this->logOperationNonCoordinator(MessageType::DELETE, transId, key, StringView(), deleteSuccess);
 
     return deleteSuccess;
 }
 
+/**
+ * FUNCTION NAME: appendPutToWal
+ *
+ * DESCRIPTION: Log a write of the local hash table ahead, if this node keeps a write-ahead log.
+ * 				It becomes durable at the next commit, at the end of the tick.
+ */
+void MP2Node::appendPutToWal(StringView key, StringView value, int timestamp, ReplicaType replica) {
+    if (this->wal == NULL)
+        return;
+
+    Entry::encode(value, timestamp, replica, this->walEntry);
+    this->wal->appendPut(key, this->walEntry);
+}
+
+/**
+ * FUNCTION NAME: recoverFromWal
+ *
+ * DESCRIPTION: Rebuild the local hash table from the write-ahead log this node left when it
+ * 				failed, so that it only needs the writes it missed from its peers.
+ * 				Writes replay last-writer-wins, as they were first applied. The replayed
+ * 				log is then compacted into a checkpoint of the rebuilt table.
+ */
+void MP2Node::recoverFromWal() {
+    string contents;
+    if (!this->wal->load(contents))
+        return;
+
+    StringView log(contents);
+    WalRecordView record;
+    EntryView entry;
+
+    while (WriteAheadLog::decodeNext(&log, &record)) {
+        if (record.type == WAL_DELETE)
+            this->ht->deleteKey(record.key);
+        else if (Entry::decode(record.entry, &entry))
+            this->ht->upsert(record.key, entry.value, entry.timestamp, entry.replica);
+    }
+
+    this->log->LOG(&this->memberNode->addr, "Recovered %lu keys from %lu bytes of write-ahead log",
+                   this->ht->currentSize(), (unsigned long) contents.size());
+    this->compactWal();
+}
+
+/**
+ * FUNCTION NAME: compactWal
+ *
+ * DESCRIPTION: Replace the write-ahead log with a checkpoint holding one record per key of
+ * 				the local hash table, dropping the overwritten and deleted writes
+ */
+void MP2Node::compactWal() {
+    string records;
+
+    for (const auto &keyValuePair : this->ht->hashTable)
+        WriteAheadLog::encode(WAL_PUT, keyValuePair.first, keyValuePair.second, records);
+
+    if (this->wal->rewrite(records))
+        this->walCheckpointSize = this->wal->size();
+}
+
 /**
  * FUNCTION NAME: checkMessages
  *
@@ -292,13 +619,24 @@ void MP2Node::checkMessages() {
         size = memberNode->mp2q.front().size;
         memberNode->mp2q.pop();
 
-        string messageString(data, data + size);
-
         /*
-         * Handle the message types here
+         * Handle the message types here. The view points into the receive buffer,
+         * which goes back to the network once the handler returns
          */
-        this->handleMessage(new Message(messageString));
-        this->analyzeQuorumConsistency();
+        MessageView view;
+        if (Message::decode(data, size, &view)) {
+            this->handleMessage(&view);
+        }
+        this->emulNet->ENrelease(data);
+    }
+
+    this->expireTransactions();
+
+    // Group commit: the writes served this tick reach the disk together, before their replies are delivered
+    if (this->wal != NULL) {
+        this->wal->commit();
+        if (this->wal->size() >= WAL_COMPACT_MIN_SIZE && this->wal->size() >= 2 * this->walCheckpointSize)
+            this->compactWal();
     }
 
     /*
@@ -307,193 +645,345 @@ void MP2Node::checkMessages() {
      */
 }
 
-void MP2Node::handleMessage(Message *msgReceived) {
-    if (msgReceived->type == MessageType::CREATE)
-        this->handleCreateMessage(msgReceived);
+void MP2Node::handleMessage(MessageView *msgReceived) {
+    if (msgReceived->type == MessageType::REPLY) {
+        this->handleReplyMessage(msgReceived);
+        return;
+    }
+
+    if (msgReceived->type == MessageType::READREPLY) {
+        this->handleReadReplyMessage(msgReceived);
+        return;
+    }
 
-    if (msgReceived->type == MessageType::READ)
-        this->handleReadMessage(msgReceived);
+    if (msgReceived->type == MessageType::BATCH) {
+        this->handleBatchMessage(msgReceived);
+        return;
+    }
 
-    if (msgReceived->type == MessageType::UPDATE)
-        this->handleUpdateMessage(msgReceived);
+    if (msgReceived->type == MessageType::BATCHREPLY) {
+        this->handleBatchReplyMessage(msgReceived);
+        return;
+    }
 
-    if (msgReceived->type == MessageType::DELETE)
-        this->handleDeleteMessage(msgReceived);
+    if (msgReceived->type == MessageType::DIGEST) {
+        if (this->isStale(msgReceived)) {
+            Message pull = this->pullMessage(msgReceived);
+            this->sendMessage(&msgReceived->fromAddr, pull);
+        }
+        return;
+    }
 
-    if (msgReceived->type == MessageType::REPLY)
-        this->handleReplyMessage(msgReceived);
+    if (msgReceived->type == MessageType::PULL) {
+        vector<Message> pushes;
+        this->answerPull(msgReceived, pushes);
+        this->sendBatch(&msgReceived->fromAddr, MessageType::BATCH, pushes);
+        return;
+    }
 
-    if (msgReceived->type == MessageType::READREPLY)
-        this->handleReadReplyMessage(msgReceived);
+    vector<Message> replies;
+    if (this->handleRequest(msgReceived, replies))
+        this->sendMessage(&msgReceived->fromAddr, replies.back());
 }
 
-void MP2Node::handleCreateMessage(Message *msgReceived) {
+/**
+ * FUNCTION NAME: handleRequest
+ *
+ * DESCRIPTION: Serve a CREATE, READ, UPDATE or DELETE request against the local hash table,
+ * 				and add the reply for the coordinator to replies. Any other type is dropped
+ *
+ * RETURNS:
+ * true if the request was served
+ */
+bool MP2Node::handleRequest(MessageView *msgReceived, vector<Message> &replies) {
+    if (msgReceived->type == MessageType::CREATE)
+        replies.push_back(this->handleCreateMessage(msgReceived));
+    else if (msgReceived->type == MessageType::READ)
+        replies.push_back(this->handleReadMessage(msgReceived));
+    else if (msgReceived->type == MessageType::UPDATE)
+        replies.push_back(this->handleUpdateMessage(msgReceived));
+    else if (msgReceived->type == MessageType::DELETE)
+        replies.push_back(this->handleDeleteMessage(msgReceived));
+    else {
+        this->log->LOG(&this->memberNode->addr, "Dropped a message of unexpected type %d, transID=%d",
+                       msgReceived->type, msgReceived->transID);
+        return false;
+    }
+    return true;
+}
+
+Message MP2Node::handleCreateMessage(MessageView *msgReceived) {
     bool createSuccess = this->createKeyValue(msgReceived->key, msgReceived->value, msgReceived->replica,
-                                              msgReceived->transID);
-    Message msg(msgReceived->transID, this->memberNode->addr, MessageType::REPLY, createSuccess);
-    this->emulNet->ENsend(&this->memberNode->addr, &msgReceived->fromAddr, msg.toString());
+                                              msgReceived->transID, msgReceived->timestamp);
+    return Message(msgReceived->transID, this->memberNode->addr, MessageType::REPLY, createSuccess);
 }
 
-void MP2Node::handleReadMessage(Message *msgReceived) {
-    string readContent = this->readKey(msgReceived->key, msgReceived->transID);
-    auto *replyMsg = new Message(msgReceived->transID, this->memberNode->addr, readContent);
-    this->emulNet->ENsend(&this->memberNode->addr, &msgReceived->fromAddr, replyMsg->toString());
+Message MP2Node::handleReadMessage(MessageView *msgReceived) {
+    StringView readContent = this->readKey(msgReceived->key, msgReceived->transID);
+    return Message(msgReceived->transID, this->memberNode->addr, readContent.toString());
 }
 
-void MP2Node::handleUpdateMessage(Message *msgReceived) {
+Message MP2Node::handleUpdateMessage(MessageView *msgReceived) {
     bool updateSuccess = this->updateKeyValue(msgReceived->key, msgReceived->value, msgReceived->replica,
-                                              msgReceived->transID);
-    auto *replyMsg = new Message(msgReceived->transID, this->memberNode->addr, MessageType::REPLY, updateSuccess);
-    this->emulNet->ENsend(&this->memberNode->addr, &msgReceived->fromAddr, replyMsg->toString());
+                                              msgReceived->transID, msgReceived->timestamp);
+    return Message(msgReceived->transID, this->memberNode->addr, MessageType::REPLY, updateSuccess);
 }
 
-void MP2Node::handleDeleteMessage(Message *msgReceived) {
+Message MP2Node::handleDeleteMessage(MessageView *msgReceived) {
     bool deleteSuccess = this->deletekey(msgReceived->key, msgReceived->transID);
-    auto *replyMsg = new Message(msgReceived->transID, this->memberNode->addr, MessageType::REPLY, deleteSuccess);
-    this->emulNet->ENsend(&this->memberNode->addr, &msgReceived->fromAddr, replyMsg->toString());
+    return Message(msgReceived->transID, this->memberNode->addr, MessageType::REPLY, deleteSuccess);
+}
+
+/**
+ * FUNCTION NAME: handleBatchMessage
+ *
+ * DESCRIPTION: Serve every request of a batch and answer them all in batch replies
+ */
+void MP2Node::handleBatchMessage(MessageView *msgReceived) {
+    StringView batch = msgReceived->value;
+    MessageView request;
+    vector<Message> replies;
+
+    while (Message::decodeNext(&batch, &request)) {
+        if (request.type != MessageType::DIGEST)
+            this->handleRequest(&request, replies);
+        else if (this->isStale(&request))
+            replies.push_back(this->pullMessage(&request));
+    }
+
+    this->sendBatch(&msgReceived->fromAddr, MessageType::BATCHREPLY, replies);
+}
+
+/**
+ * FUNCTION NAME: handleBatchReplyMessage
+ *
+ * DESCRIPTION: Count every reply of a batch reply towards its own transaction
+ */
+void MP2Node::handleBatchReplyMessage(MessageView *msgReceived) {
+    StringView batch = msgReceived->value;
+    MessageView reply;
+    vector<Message> pushes;
+
+    while (Message::decodeNext(&batch, &reply)) {
+        if (reply.type == MessageType::REPLY)
+            this->handleReplyMessage(&reply);
+
+        if (reply.type == MessageType::READREPLY)
+            this->handleReadReplyMessage(&reply);
+
+        if (reply.type == MessageType::PULL)
+            this->answerPull(&reply, pushes);
+    }
+
+    this->sendBatch(&msgReceived->fromAddr, MessageType::BATCH, pushes);
+}
+
+/**
+ * FUNCTION NAME: isStale
+ *
+ * DESCRIPTION: Whether this node lacks the key of a digest, or holds a version the offered one
+ * 				supersedes. The digest value is the fingerprint of the offered value, which
+ * 				breaks timestamp ties as in Entry::supersedes.
+ */
+bool MP2Node::isStale(MessageView *digest) {
+    EntryView entry;
+    unsigned long long offered;
+
+    if (!this->ht->find(digest->key, &entry))
+        return true;
+
+    if (entry.timestamp != digest->timestamp || digest->value.size() != sizeof(offered))
+        return entry.timestamp < digest->timestamp;
+
+    memcpy(&offered, digest->value.data(), sizeof(offered));
+    return Entry::fingerprint(entry.value) < offered;
 }
 
-void MP2Node::handleReplyMessage(Message *msgReceived) {
-    if (this->transactionsMap->find(msgReceived->transID) == this->transactionsMap->end())
+/**
+ * FUNCTION NAME: pullMessage
+ *
+ * DESCRIPTION: Ask the sender of a digest for the value it offered
+ */
+Message MP2Node::pullMessage(MessageView *digest) {
+    Message pull(-1, this->memberNode->addr, MessageType::PULL, digest->key.toString());
+    pull.replica = digest->replica;
+    return pull;
+}
+
+/**
+ * FUNCTION NAME: answerPull
+ *
+ * DESCRIPTION: Queue a CREATE carrying the local entry of a pulled key, at its stored version
+ */
+void MP2Node::answerPull(MessageView *pull, vector<Message> &pushes) {
+    EntryView entry;
+
+    if (!this->ht->find(pull->key, &entry))
+        return;
+
+    pushes.emplace_back(-1, this->memberNode->addr, MessageType::CREATE, pull->key.toString(), entry.value.toString(),
+                        pull->replica);
+    pushes.back().timestamp = entry.timestamp;
+}
+
+void MP2Node::handleReplyMessage(MessageView *msgReceived) {
+    int slot = this->findTransaction(msgReceived->transID);
+    if (slot < 0)
         return;
 
-    Transaction *transaction = (*transactionsMap)[msgReceived->transID];
+    Transaction *transaction = &this->transactions[slot];
     transaction->replyCount++;
 
     if (msgReceived->success)
         transaction->successCount++;
+
+    this->analyzeQuorumConsistency(slot);
 }
 
-void MP2Node::handleReadReplyMessage(Message *msgReceived) {
-    if (this->transactionsMap->find(msgReceived->transID) == this->transactionsMap->end())
+void MP2Node::handleReadReplyMessage(MessageView *msgReceived) {
+    int slot = this->findTransaction(msgReceived->transID);
+    if (slot < 0)
         return;
 
-    Transaction *transaction = (*transactionsMap)[msgReceived->transID];
+    Transaction *transaction = &this->transactions[slot];
     transaction->replyCount++;
-    transaction->value = msgReceived->value;
+    transaction->value = msgReceived->value.toString();
 
     if (!msgReceived->value.empty())
         transaction->successCount++;
-}
 
+    this->analyzeQuorumConsistency(slot);
+}
 
-void MP2Node::analyzeQuorumConsistency() {
-    for (auto transactionIterator = this->transactionsMap->begin();
-         transactionIterator != this->transactionsMap->end();
-         transactionIterator++) {
-        Transaction *transaction = transactionIterator->second;
+/**
+ * FUNCTION NAME: findTransaction
+ *
+ * DESCRIPTION: Look up an in-flight coordinator transaction
+ *
+ * RETURNS:
+ * its slot in the transaction pool, or -1 if it was already decided
+ */
+int MP2Node::findTransaction(int transId) {
+    return this->transactionIndex.find(transId);
+}
 
-        // Values to analyze consistency
-        int transactionReplyCount = transaction->replyCount;
-        int transactionSuccessCount = transaction->successCount;
-        int transactionTimestamp = transaction->getTime();
-        int currentTimestamp = this->par->getcurrtime();
+/**
+ * FUNCTION NAME: analyzeQuorumConsistency
+ *
+ * DESCRIPTION: Decide a transaction once a reply for it arrives: it succeeds as soon as the
+ * 				replicas its consistency level asks for succeeded and fails as soon as that
+ * 				can no longer happen
+ */
+void MP2Node::analyzeQuorumConsistency(int slot) {
+    Transaction *transaction = &this->transactions[slot];
+    int failureCount = transaction->replyCount - transaction->successCount;
 
-        // Consistency Analysis
-        if (transactionReplyCount == 3 && transactionSuccessCount > 1) {
-            this->logOperationCoordinator(transaction, true);
-            this->deleteTransaction(transactionIterator);
-            continue;
-        }
+    if (transaction->successCount >= transaction->requiredCount) {
+        this->logOperationCoordinator(transaction, true);
+        this->deleteTransaction(slot);
+        return;
+    }
 
-        if (transactionReplyCount != 3 && transactionSuccessCount == 2) {
-            this->logOperationCoordinator(transaction, true);
-            this->deleteTransaction(transactionIterator);
-            continue;
-        }
+    if (failureCount > transaction->replicaCount - transaction->requiredCount) {
+        this->logOperationCoordinator(transaction, false);
+        this->deleteTransaction(slot);
+    }
+}
 
-        if (transactionReplyCount == 3 && transactionSuccessCount < 2) {
-            this->logOperationCoordinator(transaction, false);
-            this->deleteTransaction(transactionIterator);
-            continue;
-        }
+/**
+ * FUNCTION NAME: expireTransactions
+ *
+ * DESCRIPTION: Fail every transaction that did not reach a decision within TRANSACTION_TIMEOUT ticks
+ */
+void MP2Node::expireTransactions() {
+    vector<unsigned long long> due;
+    this->transactionTimeouts.advance(this->par->getcurrtime(), due);
 
-        if (transactionReplyCount - transactionSuccessCount == 2) {
-            this->logOperationCoordinator(transaction, false);
-            this->deleteTransaction(transactionIterator);
+    for (unsigned long long transId : due) {
+        int slot = this->findTransaction((int) transId);
+        if (slot < 0)
             continue;
-        }
 
-        if (currentTimestamp - transactionTimestamp > 10) {
-            this->logOperationCoordinator(transaction, false);
-            this->deleteTransaction(transactionIterator);
-            continue;
-        }
+        // The wheel already released the timer that fired
+        this->transactions[slot].timer = -1;
+        this->logOperationCoordinator(&this->transactions[slot], false);
+        this->deleteTransaction(slot);
     }
 }
 
 void MP2Node::logOperationCoordinator(Transaction *transaction, bool operationSuccess) {
-    if (transaction->msgType == MessageType::CREATE)
-        this->logCreate(transaction, true, operationSuccess);
-
-    if (transaction->msgType == MessageType::READ)
-        this->logRead(transaction, true, operationSuccess);
-
-    if (transaction->msgType == MessageType::UPDATE)
-        this->logUpdate(transaction, true, operationSuccess);
+    this->logOperation(transaction->msgType, transaction->getId(), transaction->key, transaction->value, true,
+                       operationSuccess);
+}
 
-    if (transaction->msgType == MessageType::DELETE)
-        this->logDelete(transaction, true, operationSuccess);
+void MP2Node::logOperationNonCoordinator(MessageType msgType, int transId, StringView key, StringView value,
+                                         bool operationSuccess) {
+    this->logOperation(msgType, transId, key, value, false, operationSuccess);
 }
 
-void MP2Node::logOperationNonCoordinator(Transaction *transaction, bool operationSuccess) {
-    if (transaction->msgType == MessageType::CREATE)
-        this->logCreate(transaction, false, operationSuccess);
+void MP2Node::logOperation(MessageType msgType, int transId, StringView key, StringView value, bool isCoordinator,
+                           bool operationSuccess) {
+    if (msgType == MessageType::CREATE)
+        this->logCreate(transId, key, value, isCoordinator, operationSuccess);
 
-    if (transaction->msgType == MessageType::READ)
-        this->logRead(transaction, false, operationSuccess);
+    if (msgType == MessageType::READ)
+        this->logRead(transId, key, value, isCoordinator, operationSuccess);
 
-    if (transaction->msgType == MessageType::UPDATE)
-        this->logUpdate(transaction, false, operationSuccess);
+    if (msgType == MessageType::UPDATE)
+        this->logUpdate(transId, key, value, isCoordinator, operationSuccess);
 
-    if (transaction->msgType == MessageType::DELETE)
-        this->logDelete(transaction, false, operationSuccess);
+    if (msgType == MessageType::DELETE)
+        this->logDelete(transId, key, isCoordinator, operationSuccess);
 }
 
-void MP2Node::logCreate(Transaction *transaction, bool isCoordinator, bool createOperationSuccess) {
+void MP2Node::logCreate(int transId, StringView key, StringView value, bool isCoordinator,
+                        bool createOperationSuccess) {
     if (createOperationSuccess) {
-        this->log->logCreateSuccess(&this->memberNode->addr, isCoordinator, transaction->getId(), transaction->key,
-                                    transaction->value);
+        this->log->logCreateSuccess(&this->memberNode->addr, isCoordinator, transId, key, value);
         return;
     }
 
-    this->log->logCreateFail(&this->memberNode->addr, isCoordinator, transaction->getId(), transaction->key,
-                             transaction->value);
+    this->log->logCreateFail(&this->memberNode->addr, isCoordinator, transId, key, value);
 }
 
-void MP2Node::logRead(Transaction *transaction, bool isCoordinator, bool readOperationSuccess) {
+void MP2Node::logRead(int transId, StringView key, StringView value, bool isCoordinator, bool readOperationSuccess) {
     if (readOperationSuccess) {
-        this->log->logReadSuccess(&this->memberNode->addr, isCoordinator, transaction->getId(), transaction->key,
-                                  transaction->value);
+        this->log->logReadSuccess(&this->memberNode->addr, isCoordinator, transId, key, value);
         return;
     }
 
-    this->log->logReadFail(&this->memberNode->addr, isCoordinator, transaction->getId(), transaction->key);
+    this->log->logReadFail(&this->memberNode->addr, isCoordinator, transId, key);
 }
 
-void MP2Node::logUpdate(Transaction *transaction, bool isCoordinator, bool updateOperationSuccess) {
+void MP2Node::logUpdate(int transId, StringView key, StringView value, bool isCoordinator,
+                        bool updateOperationSuccess) {
     if (updateOperationSuccess) {
-        this->log->logUpdateSuccess(&this->memberNode->addr, isCoordinator, transaction->getId(), transaction->key,
-                                    transaction->value);
+        this->log->logUpdateSuccess(&this->memberNode->addr, isCoordinator, transId, key, value);
         return;
     }
 
-    this->log->logUpdateFail(&this->memberNode->addr, isCoordinator, transaction->getId(), transaction->key,
-                             transaction->value);
+    this->log->logUpdateFail(&this->memberNode->addr, isCoordinator, transId, key, value);
 }
 
-void MP2Node::logDelete(Transaction *transaction, bool isCoordinator, bool deleteOperationSuccess) {
+void MP2Node::logDelete(int transId, StringView key, bool isCoordinator, bool deleteOperationSuccess) {
     if (deleteOperationSuccess) {
-        this->log->logDeleteSuccess(&this->memberNode->addr, isCoordinator, transaction->getId(), transaction->key);
+        this->log->logDeleteSuccess(&this->memberNode->addr, isCoordinator, transId, key);
         return;
     }
 
-    this->log->logDeleteFail(&this->memberNode->addr, isCoordinator, transaction->getId(), transaction->key);
+    this->log->logDeleteFail(&this->memberNode->addr, isCoordinator, transId, key);
 }
 
-void MP2Node::deleteTransaction(map<int, Transaction *>::iterator transactionIterator) {
-    delete transactionIterator->second;
-    this->transactionsMap->erase(transactionIterator);
+void MP2Node::deleteTransaction(int slot) {
+    Transaction *transaction = &this->transactions[slot];
+
+    if (transaction->timer >= 0)
+        this->transactionTimeouts.cancel(transaction->timer);
+
+    this->transactionIndex.erase(transaction->getId());
+    transaction->key.clear();
+    transaction->value.clear();
+    this->freeTransactions.push_back(slot);
 }
 
 /**
@@ -503,28 +993,63 @@ void MP2Node::deleteTransaction(map<int, Transaction *>::iterator transactionIte
  * 				This function is responsible for finding the replicas of a key
  */
 vector<Node> MP2Node::findNodes(string key) {
-    size_t pos = hashFunction(key);
     vector<Node> addr_vec;
-    if (ring.size() >= 3) {
-        // if pos <= min || pos > max, the leader is the min
-        if (pos <= ring.at(0).getHashCode() || pos > ring.at(ring.size() - 1).getHashCode()) {
-            addr_vec.emplace_back(ring.at(0));
-            addr_vec.emplace_back(ring.at(1));
-            addr_vec.emplace_back(ring.at(2));
-        } else {
-            // go through the ring until pos <= node
-            for (int i = 1; i < ring.size(); i++) {
-                Node addr = ring.at(i);
-                if (pos <= addr.getHashCode()) {
-                    addr_vec.emplace_back(addr);
-                    addr_vec.emplace_back(ring.at((i + 1) % ring.size()));
-                    addr_vec.emplace_back(ring.at((i + 2) % ring.size()));
-                    break;
-                }
-            }
+    const int *successors = this->findReplicas(hashFunction(key), this->ringHashes, this->ringSuccessors);
+
+    if (successors == NULL)
+        return addr_vec;
+
+    for (int replica = 0; replica < this->par->REPLICATION_FACTOR; replica++)
+        addr_vec.emplace_back(this->ring[successors[replica]]);
+
+    return addr_vec;
+}
+
+/**
+ * FUNCTION NAME: sendMessage
+ *
+ * DESCRIPTION: Encode a message straight into a network buffer and send it
+ *
+ * RETURNS:
+ * false if the message does not fit in a network message
+ */
+bool MP2Node::sendMessage(Address *toAddress, Message &message) {
+    int size = message.encodedSize();
+    char *buffer = this->emulNet->ENbuffer(size);
+
+    if (buffer == NULL)
+        return false;
+
+    message.encode(buffer);
+    this->emulNet->ENsendBuffer(&this->memberNode->addr, toAddress, buffer, size);
+    return true;
+}
+
+/**
+ * FUNCTION NAME: sendBatch
+ *
+ * DESCRIPTION: Send messages to one node in as few BATCH or BATCHREPLY messages as fit
+ * 				in a network message. A lone message is sent as is.
+ */
+void MP2Node::sendBatch(Address *toAddress, MessageType batchType, vector<Message> &messages) {
+    if (messages.size() == 1) {
+        this->sendMessage(toAddress, messages[0]);
+        return;
+    }
+
+    int maxSize = this->emulNet->ENmaxPayload();
+    Message batch(0, this->memberNode->addr, batchType, "");
+
+    for (auto &message : messages) {
+        if (!batch.value.empty() && batch.encodedSize() + message.encodedSize() > maxSize) {
+            this->sendMessage(toAddress, batch);
+            batch.value.clear();
         }
+        batch.append(message);
     }
-    return addr_vec;
+
+    if (!batch.value.empty())
+        this->sendMessage(toAddress, batch);
 }
 
 /**
@@ -556,26 +1081,100 @@ int MP2Node::enqueueWrapper(void *env, char *buff, int size) {
  * DESCRIPTION: This runs the stabilization protocol in case of Node joins and leaves
  * 				It ensures that there always 3 copies of all keys in the DHT at all times
  * 				The function does the following:
- *				1) Ensures that there are three "CORRECT" replicas of all the keys in spite of failures and joins
- *				Note:- "CORRECT" replicas implies that every key is replicated in its two neighboring nodes in the ring
+ *				1) Rebuilds the ring as it was before the nodes that joined and left since the last run
+ *				2) For every local key whose replicas changed, lets a single sender, the first of the
+ *				   previous replicas still in the ring, create the key on the replicas it gained,
+ *				   at its stored version so that a replica holding a newer one keeps it
+ *				3) Offers values of STABILIZATION_DIGEST_MIN_SIZE bytes or more as a digest first,
+ *				   so that they only travel to replicas that pull them
+ *				4) Batches those creates and digests per replica
  */
-void MP2Node::stabilizationProtocol() {
+void MP2Node::stabilizationProtocol(vector<Node> &joined, vector<Node> &left) {
+    int replicationFactor = this->par->REPLICATION_FACTOR;
+
+    // 1. The previous ring: the current one without the nodes that joined, plus the ones that left
+    vector<Node> previousRing;
+    for (auto &node : this->ring) {
+        if (!this->containsNode(joined, *node.getAddress()))
+            previousRing.push_back(node);
+    }
+    previousRing.insert(previousRing.end(), left.begin(), left.end());
+    sort(previousRing.begin(), previousRing.end());
+
+    vector<unsigned long long> previousHashes;
+    vector<int> previousSuccessors;
+    this->buildRingIndex(previousRing, previousHashes, previousSuccessors);
+
+    // 2. Creates and digests owed to each gained replica, keyed by its address
+    map<string, pair<Address, vector<Message>>> batches;
+
     for (const auto &keyValuePair : this->ht->hashTable) {
-        string key = keyValuePair.first;
-        string value = keyValuePair.second;
+        EntryView entry;
+        if (!Entry::decode(keyValuePair.second, &entry))
+            continue;
 
-        vector<Node> replicas = this->findNodes(key);
+        unsigned long long pos = hashFunction(keyValuePair.first);
+        const int *current = this->findReplicas(pos, this->ringHashes, this->ringSuccessors);
+        const int *previous = this->findReplicas(pos, previousHashes, previousSuccessors);
 
-        for (auto &replica : replicas) {
-            int transactionId = -1;
-            Address fromAddress = this->memberNode->addr;
-            Address *toAddress = replica.getAddress();
-            MessageType msgType = MessageType::CREATE;
+        if (current == NULL)
+            continue;
 
-            Message *msg = new Message(transactionId, fromAddress, msgType, key, value);
-            string msgData = msg->toString();
+        // Without a surviving previous replica, every node still holding the key pushes it
+        Address *sender = &this->memberNode->addr;
+        for (int replica = 0; previous != NULL && replica < replicationFactor; replica++) {
+            Address *candidate = previousRing[previous[replica]].getAddress();
+            if (!this->containsNode(left, *candidate)) {
+                sender = candidate;
+                break;
+            }
+        }
+        if (!(*sender == this->memberNode->addr))
+            continue;
 
-            this->emulNet->ENsend(&fromAddress, toAddress, msgData);
+        for (int replica = 0; replica < replicationFactor; replica++) {
+            Address *target = this->ring[current[replica]].getAddress();
+            if (*target == this->memberNode->addr)
+                continue;
+
+            bool alreadyReplica = false;
+            for (int old = 0; previous != NULL && old < replicationFactor; old++)
+                alreadyReplica = alreadyReplica || *previousRing[previous[old]].getAddress() == *target;
+            if (alreadyReplica)
+                continue;
+
+            auto &batch = batches[target->getAddress()];
+            batch.first = *target;
+            // 3. Large values go as a digest, which the target pulls only if its copy is older
+            if (entry.value.size() >= STABILIZATION_DIGEST_MIN_SIZE) {
+                unsigned long long fingerprint = Entry::fingerprint(entry.value);
+                batch.second.emplace_back(-1, this->memberNode->addr, MessageType::DIGEST,
+                                          keyValuePair.first.toString(),
+                                          string((const char *) &fingerprint, sizeof(fingerprint)));
+            } else {
+                batch.second.emplace_back(-1, this->memberNode->addr, MessageType::CREATE,
+                                          keyValuePair.first.toString(), entry.value.toString());
+            }
+            batch.second.back().timestamp = entry.timestamp;
+            batch.second.back().replica = this->replicaType(replica);
         }
     }
+
+    // 4. One batch per gained replica
+    for (auto &batch : batches)
+        this->sendBatch(&batch.second.first, MessageType::BATCH, batch.second.second);
+}
+
+/**
+ * FUNCTION NAME: containsNode
+ *
+ * DESCRIPTION: Whether a node with the given address is in nodes
+ */
+bool MP2Node::containsNode(vector<Node> &nodes, Address &address) {
+    for (auto &node : nodes) {
+        if (*node.getAddress() == address)
+            return true;
+    }
+
+    return false;
 }
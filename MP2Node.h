@@ -18,9 +18,25 @@
 #include "Params.h"
 #include "Message.h"
 #include "Queue.h"
+#include "HashIndex.h"
+#include "TimerWheel.h"
+#include "WriteAheadLog.h"
 
 using namespace std;
 
+/**
+ * Macros
+ */
+// Ticks a coordinator waits for a quorum before failing the operation
+#define TRANSACTION_TIMEOUT 10
+// Stabilization offers values at least this long as a digest, and only sends them if pulled
+#define STABILIZATION_DIGEST_MIN_SIZE 64
+// Write-ahead logs are named after this prefix and the node address
+#define WAL_FILE_PREFIX "wal_"
+// A write-ahead log is compacted into a checkpoint once it is this long and has doubled
+// since its last checkpoint
+#define WAL_COMPACT_MIN_SIZE (64 * 1024)
+
 class Transaction {
 private:
     int id;
@@ -33,6 +49,11 @@ public:
     string value;
     int replyCount;
     int successCount;
+    // Replicas the operation was sent to, and successful replies it needs
+    int replicaCount;
+    int requiredCount;
+    // Handle of the timeout scheduled in the coordinator's transaction wheel
+    int timer;
 
     int getId() { return id; };
 
@@ -55,8 +76,12 @@ private:
     vector<Node> hasMyReplicas;
     // Vector holding the previous two neighbors in the ring whose replicas I have
     vector<Node> haveReplicasOf;
-    // Ring
+    // Ring of physical nodes, sorted by hash code
     vector<Node> ring;
+    // Token table: positions of the VNODES tokens of every ring node, sorted, for binary search
+    vector<unsigned long long> ringHashes;
+    // For each token, the Params::REPLICATION_FACTOR distinct ring nodes holding the keys it owns
+    vector<int> ringSuccessors;
     // Hash Table
     HashTable *ht;
     // Member representing this member
@@ -67,11 +92,23 @@ private:
     EmulNet *emulNet;
     // Object of Log
     Log *log;
-    // Transactions Map
-    map<int, Transaction *> *transactionsMap;
+    // Pool of in-flight coordinator transactions, slots are reused through freeTransactions
+    vector<Transaction> transactions;
+    vector<int> freeTransactions;
+    // transID -> slot in transactions
+    HashIndex transactionIndex;
+    // Timeouts of in-flight transactions, keyed by transID
+    TimerWheel transactionTimeouts;
+    // Write-ahead log of the local hash table when Params::WAL is set, else NULL
+    WriteAheadLog *wal;
+    // Stored form of the entry being logged
+    string walEntry;
+    // Size of the write-ahead log after its last checkpoint
+    unsigned long walCheckpointSize;
 
 public:
-    MP2Node(Member *memberNode, Params *par, EmulNet *emulNet, Log *log, Address *addressOfMember);
+    MP2Node(Member *memberNode, Params *par, EmulNet *emulNet, Log *log, Address *addressOfMember,
+            bool restarted = false);
 
     Member *getMemberNode() {
         return this->memberNode;
@@ -82,18 +119,62 @@ public:
 
     vector<Node> getMembershipList();
 
-    size_t hashFunction(string key);
+    unsigned long long hashFunction(StringView key);
 
     void findNeighbors();
 
-    // client side CRUD APIs
-    void clientCreate(string key, string value);
+    void buildRingIndex(vector<Node> &nodes, vector<unsigned long long> &hashes, vector<int> &successorTable);
+
+    const int *findReplicas(unsigned long long pos, const vector<unsigned long long> &hashes,
+                            const vector<int> &successorTable);
+
+    bool insertRingNode(Node &node);
+
+    bool removeRingNode(Node &node);
+
+    // client side CRUD APIs, at the consistency levels configured in Params unless one is given
+    void clientCreate(string key, string value) {
+        this->clientCreate(move(key), move(value), (ConsistencyLevel) this->par->WRITE_CONSISTENCY);
+    }
+
+    void clientRead(string key) {
+        this->clientRead(move(key), (ConsistencyLevel) this->par->READ_CONSISTENCY);
+    }
+
+    void clientUpdate(string key, string value) {
+        this->clientUpdate(move(key), move(value), (ConsistencyLevel) this->par->WRITE_CONSISTENCY);
+    }
+
+    void clientDelete(string key) {
+        this->clientDelete(move(key), (ConsistencyLevel) this->par->WRITE_CONSISTENCY);
+    }
+
+    void clientCreate(string key, string value, ConsistencyLevel level);
+
+    void clientRead(string key, ConsistencyLevel level);
+
+    void clientUpdate(string key, string value, ConsistencyLevel level);
 
-    void clientRead(string key);
+    void clientDelete(string key, ConsistencyLevel level);
 
-    void clientUpdate(string key, string value);
+    // batched client side APIs, one message per replica for all the keys
+    void multiGet(const vector<string> &keys) {
+        this->multiGet(keys, (ConsistencyLevel) this->par->READ_CONSISTENCY);
+    }
+
+    void multiPut(const map<string, string> &keyValues) {
+        this->multiPut(keyValues, (ConsistencyLevel) this->par->WRITE_CONSISTENCY);
+    }
+
+    void multiDelete(const vector<string> &keys) {
+        this->multiDelete(keys, (ConsistencyLevel) this->par->WRITE_CONSISTENCY);
+    }
 
-    void clientDelete(string key);
+    void multiGet(const vector<string> &keys, ConsistencyLevel level);
+
+    void multiPut(const map<string, string> &keyValues, ConsistencyLevel level);
+
+    void multiDelete(const vector<string> &keys, ConsistencyLevel level);
 
     // receive messages from Emulnet
     bool recvLoop();
@@ -106,53 +187,95 @@ public:
     // coordinator dispatches messages to corresponding nodes
     void dispatchMessages(Message message);
 
+    bool sendMessage(Address *toAddress, Message &message);
+
+    void sendBatch(Address *toAddress, MessageType batchType, vector<Message> &messages);
+
     // find the addresses of nodes that are responsible for a key
     vector<Node> findNodes(string key);
 
     // server
-    bool createKeyValue(string key, string value, ReplicaType replica, int transId);
+    bool createKeyValue(StringView key, StringView value, ReplicaType replica, int transId, int timestamp);
+
+    StringView readKey(StringView key, int transId);
+
+    bool updateKeyValue(StringView key, StringView value, ReplicaType replica, int transId, int timestamp);
 
-    string readKey(string key, int transId);
+    bool deletekey(StringView key, int transId);
 
-    bool updateKeyValue(string key, string value, ReplicaType replica, int transId);
+    // write-ahead log of the server side writes
+    void appendPutToWal(StringView key, StringView value, int timestamp, ReplicaType replica);
 
-    bool deletekey(string key, int transId);
+    void recoverFromWal();
+
+    void compactWal();
 
     // stabilization protocol - handle multiple failures
-    void stabilizationProtocol();
+    void stabilizationProtocol(vector<Node> &joined, vector<Node> &left);
+
+    bool containsNode(vector<Node> &nodes, Address &address);
 
     // user-defined functions
-    void clientPerformOperation(MessageType msgType, string key, string value = "");
+    void clientPerformOperation(MessageType msgType, ConsistencyLevel level, string key, string value = "");
+
+    void clientPerformBatch(MessageType msgType, ConsistencyLevel level, const vector<pair<string, string>> &operations);
+
+    int beginTransaction(MessageType msgType, ConsistencyLevel level, const string &key, const string &value,
+                         int replicaCount);
+
+    ReplicaType replicaType(int position);
 
-    void handleMessage(Message *msgReceived);
+    int requiredReplies(ConsistencyLevel level, int replicaCount);
 
-    void handleCreateMessage(Message *msgReceived);
+    void handleMessage(MessageView *msgReceived);
 
-    void handleReadMessage(Message *msgReceived);
+    bool handleRequest(MessageView *msgReceived, vector<Message> &replies);
 
-    void handleUpdateMessage(Message *msgReceived);
+    Message handleCreateMessage(MessageView *msgReceived);
 
-    void handleDeleteMessage(Message *msgReceived);
+    Message handleReadMessage(MessageView *msgReceived);
 
-    void handleReplyMessage(Message *msgReceived);
+    Message handleUpdateMessage(MessageView *msgReceived);
 
-    void handleReadReplyMessage(Message *msgReceived);
+    Message handleDeleteMessage(MessageView *msgReceived);
 
-    void analyzeQuorumConsistency();
+    void handleBatchMessage(MessageView *msgReceived);
+
+    void handleBatchReplyMessage(MessageView *msgReceived);
+
+    bool isStale(MessageView *digest);
+
+    Message pullMessage(MessageView *digest);
+
+    void answerPull(MessageView *pull, vector<Message> &pushes);
+
+    void handleReplyMessage(MessageView *msgReceived);
+
+    void handleReadReplyMessage(MessageView *msgReceived);
+
+    int findTransaction(int transId);
+
+    void analyzeQuorumConsistency(int slot);
+
+    void expireTransactions();
 
     void logOperationCoordinator(Transaction *transaction, bool operationSuccess);
 
-    void logOperationNonCoordinator(Transaction *transaction, bool operationSuccess);
+    void logOperationNonCoordinator(MessageType msgType, int transId, StringView key, StringView value,
+                                    bool operationSuccess);
+
+    void logOperation(MessageType msgType, int transId, StringView key, StringView value, bool isCoordinator,
+                      bool operationSuccess);
 
-    void logCreate(Transaction *transaction, bool isCoordinator, bool createOperationSuccess);
+    void logCreate(int transId, StringView key, StringView value, bool isCoordinator, bool createOperationSuccess);
 
-    void logRead(Transaction *transaction, bool isCoordinator, bool readOperationSuccess);
+    void logRead(int transId, StringView key, StringView value, bool isCoordinator, bool readOperationSuccess);
 
-    void logUpdate(Transaction *transaction, bool isCoordinator, bool updateOperationSuccess);
+    void logUpdate(int transId, StringView key, StringView value, bool isCoordinator, bool updateOperationSuccess);
 
-    void logDelete(Transaction *transaction, bool isCoordinator, bool deleteOperationSuccess);
+    void logDelete(int transId, StringView key, bool isCoordinator, bool deleteOperationSuccess);
 
-    void deleteTransaction(map<int, Transaction *>::iterator transactionIterator);
+    void deleteTransaction(int slot);
 
     ~MP2Node();
 };
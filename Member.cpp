@@ -153,6 +153,7 @@ Member::Member(const Member &anotherMember) {
 	this->timeOutCounter = anotherMember.timeOutCounter;
 	this->memberList = anotherMember.memberList;
 	this->myPos = anotherMember.myPos;
+	this->memberEvents = anotherMember.memberEvents;
 	this->mp1q = anotherMember.mp1q;
 	this->mp2q = anotherMember.mp2q;
 }
@@ -171,6 +172,7 @@ Member& Member::operator =(const Member& anotherMember) {
 	this->timeOutCounter = anotherMember.timeOutCounter;
 	this->memberList = anotherMember.memberList;
 	this->myPos = anotherMember.myPos;
+	this->memberEvents = anotherMember.memberEvents;
 	this->mp1q = anotherMember.mp1q;
 	this->mp2q = anotherMember.mp2q;
 	return *this;
@@ -80,6 +80,17 @@ public:
 	void settimestamp(long timestamp);
 };
 
+/**
+ * STRUCT NAME: MemberEvent
+ *
+ * DESCRIPTION: A member added to or removed from the membership list, published by the
+ * 				membership protocol for the key-value store ring
+ */
+typedef struct MemberEvent {
+	Address addr;
+	bool joined;
+}MemberEvent;
+
 /**
  * CLASS NAME: Member
  *
@@ -108,6 +119,8 @@ public:
 	vector<MemberListEntry> memberList;
 	// My position in the membership table
 	vector<MemberListEntry>::iterator myPos;
+	// Membership changes not yet applied to the ring
+	vector<MemberEvent> memberEvents;
 	// Queue for failure detection messages
 	queue<q_elt> mp1q;
 	// Queue for KVstore messages
@@ -8,51 +8,16 @@
 /**
  * Constructor
  */
-// transID::fromAddr::CREATE::key::value::ReplicaType
-// transID::fromAddr::READ::key
-// transID::fromAddr::UPDATE::key::value::ReplicaType
-// transID::fromAddr::DELETE::key
-// transID::fromAddr::REPLY::sucess
-// transID::fromAddr::READREPLY::value
-Message::Message(string message){
-	this->delimiter = "::";
-	vector<string> tuple;
-	size_t pos = message.find(delimiter);
-	size_t start = 0;
-	while (pos != string::npos) {
-		string field = message.substr(start, pos-start);
-		tuple.push_back(field);
-		start = pos + 2;
-		pos = message.find(delimiter, start);
-	}
-	tuple.push_back(message.substr(start));
-
-	transID = stoi(tuple.at(0));
-	Address addr(tuple.at(1));
-	fromAddr = addr;
-	type = static_cast<MessageType>(stoi(tuple.at(2)));
-	switch(type){
-		case CREATE:
-		case UPDATE:
-			key = tuple.at(3);
-			value = tuple.at(4);
-			if (tuple.size() > 5)
-				replica = static_cast<ReplicaType>(stoi(tuple.at(5)));
-			break;
-		case READ:
-		case DELETE:
-			key = tuple.at(3);
-			break;
-		case REPLY:
-			if (tuple.at(3) == "1")
-				success = true;
-			else
-				success = false;
-			break;
-		case READREPLY:
-			value = tuple.at(3);
-			break;
-	}
+// construct a message from a decoded view, copying its key and value
+Message::Message(const MessageView &view){
+	transID = view.transID;
+	timestamp = view.timestamp;
+	fromAddr = view.fromAddr;
+	type = view.type;
+	replica = view.replica;
+	success = view.success;
+	key = view.key.toString();
+	value = view.value.toString();
 }
 
 /**
@@ -60,25 +25,26 @@ Message::Message(string message){
  */
 // construct a create or update message
 Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value, ReplicaType _replica){
-	this->delimiter = "::";
 	transID = _transID;
+	timestamp = 0;
 	fromAddr = _fromAddr;
 	type = _type;
 	key = _key;
 	value = _value;
 	replica = _replica;
+	success = false;
 }
 
 /**
  * Constructor
  */
 Message::Message(const Message& anotherMessage) {
-	this->delimiter = anotherMessage.delimiter;
 	this->fromAddr = anotherMessage.fromAddr;
 	this->key = anotherMessage.key;
 	this->replica = anotherMessage.replica;
 	this->success = anotherMessage.success;
 	this->transID = anotherMessage.transID;
+	this->timestamp = anotherMessage.timestamp;
 	this->type = anotherMessage.type;
 	this->value = anotherMessage.value;
 }
@@ -87,12 +53,14 @@ Message::Message(const Message& anotherMessage) {
  * Constructor
  */
 Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value){
-	this->delimiter = "::";
 	transID = _transID;
+	timestamp = 0;
 	fromAddr = _fromAddr;
 	type = _type;
 	key = _key;
 	value = _value;
+	replica = PRIMARY;
+	success = false;
 }
 
 /**
@@ -100,11 +68,13 @@ Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key
  */
 // construct a read or delete message
 Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key){
-	this->delimiter = "::";
 	transID = _transID;
+	timestamp = 0;
 	fromAddr = _fromAddr;
 	type = _type;
 	key = _key;
+	replica = PRIMARY;
+	success = false;
 }
 
 /**
@@ -112,10 +82,11 @@ Message::Message(int _transID, Address _fromAddr, MessageType _type, string _key
  */
 // construct reply message
 Message::Message(int _transID, Address _fromAddr, MessageType _type, bool _success){
-	this->delimiter = "::";
 	transID = _transID;
+	timestamp = 0;
 	fromAddr = _fromAddr;
 	type = _type;
+	replica = PRIMARY;
 	success = _success;
 }
 
@@ -124,52 +95,160 @@ Message::Message(int _transID, Address _fromAddr, MessageType _type, bool _succe
  */
 // construct read reply message
 Message::Message(int _transID, Address _fromAddr, string _value){
-	this->delimiter = "::";
 	transID = _transID;
+	timestamp = 0;
 	fromAddr = _fromAddr;
 	type = READREPLY;
+	replica = PRIMARY;
+	success = false;
 	value = _value;
 }
 
 /**
- * FUNCTION NAME: toString
+ * FUNCTION NAME: encodedSize
+ *
+ * DESCRIPTION: Number of bytes encode writes for this message
+ */
+int Message::encodedSize(){
+	return MESSAGE_HEADER_SIZE + key.size() + value.size();
+}
+
+/**
+ * FUNCTION NAME: encodedSize
+ *
+ * DESCRIPTION: Number of bytes the message a view was decoded from takes on the wire
+ */
+int Message::encodedSize(const MessageView &view){
+	return MESSAGE_HEADER_SIZE + view.key.size() + view.value.size();
+}
+
+/**
+ * FUNCTION NAME: encode
+ *
+ * DESCRIPTION: Serialize the message into the buffer
  *
- * DESCRIPTION: Serialized Message in string format
+ * RETURNS:
+ * number of bytes written
  */
-string Message::toString(){
-	string message = to_string(transID) + delimiter + fromAddr.getAddress() + delimiter + to_string(type) + delimiter;
-	switch(type){
-		case CREATE:
-		case UPDATE:
-			message += key + delimiter + value + delimiter + to_string(replica);
-			break;
-		case READ:
-		case DELETE:
-			message += key;
-			break;
-		case REPLY:
-			if (success)
-				message += "1";
-			else
-				message += "0";
-			break;
-		case READREPLY:
-			message += value;
-			break;
+int Message::encode(char *buffer){
+	char *ptr = buffer;
+	int keyLength = key.size();
+	int valueLength = value.size();
+
+	*ptr++ = MESSAGE_VERSION;
+	*ptr++ = (char) type;
+	*ptr++ = (char) replica;
+	*ptr++ = success ? 1 : 0;
+	memcpy(ptr, &transID, sizeof(int));
+	ptr += sizeof(int);
+	memcpy(ptr, &timestamp, sizeof(int));
+	ptr += sizeof(int);
+	memcpy(ptr, fromAddr.addr, sizeof(fromAddr.addr));
+	ptr += sizeof(fromAddr.addr);
+	memcpy(ptr, &keyLength, sizeof(int));
+	ptr += sizeof(int);
+	memcpy(ptr, key.data(), keyLength);
+	ptr += keyLength;
+	memcpy(ptr, &valueLength, sizeof(int));
+	ptr += sizeof(int);
+	memcpy(ptr, value.data(), valueLength);
+	ptr += valueLength;
+
+	return ptr - buffer;
+}
+
+/**
+ * FUNCTION NAME: decode
+ *
+ * DESCRIPTION: Decode a message in place. The key and value of the view point into data.
+ *
+ * RETURNS:
+ * false if the message is truncated, of another version, or of an unknown type or replica
+ */
+bool Message::decode(const char *data, int size, MessageView *view){
+	const char *ptr = data;
+	const char *end = data + size;
+	int keyLength;
+	int valueLength;
+
+	if ( size < MESSAGE_HEADER_SIZE || data[0] != MESSAGE_VERSION ) {
+		return false;
 	}
-	return message;
+
+	if ( (unsigned char) ptr[1] > PULL || (unsigned char) ptr[2] > TERTIARY ) {
+		return false;
+	}
+	view->type = static_cast<MessageType>(ptr[1]);
+	view->replica = static_cast<ReplicaType>(ptr[2]);
+	view->success = ptr[3] != 0;
+	ptr += 4;
+	memcpy(&view->transID, ptr, sizeof(int));
+	ptr += sizeof(int);
+	memcpy(&view->timestamp, ptr, sizeof(int));
+	ptr += sizeof(int);
+	memcpy(view->fromAddr.addr, ptr, sizeof(view->fromAddr.addr));
+	ptr += sizeof(view->fromAddr.addr);
+
+	memcpy(&keyLength, ptr, sizeof(int));
+	ptr += sizeof(int);
+	// The header counted the value length field, so end - ptr - sizeof(int) is not
+	// negative, and comparing against it cannot overflow the way keyLength + 4 could
+	if ( keyLength < 0 || keyLength > end - ptr - (ptrdiff_t) sizeof(int) ) {
+		return false;
+	}
+	view->key = StringView(ptr, keyLength);
+	ptr += keyLength;
+
+	memcpy(&valueLength, ptr, sizeof(int));
+	ptr += sizeof(int);
+	if ( valueLength < 0 || valueLength > end - ptr ) {
+		return false;
+	}
+	view->value = StringView(ptr, valueLength);
+
+	return true;
+}
+
+/**
+ * FUNCTION NAME: append
+ *
+ * DESCRIPTION: Add the encoding of a message to the value of this BATCH or BATCHREPLY message
+ */
+void Message::append(Message &message){
+	int offset = value.size();
+
+	value.resize(offset + message.encodedSize());
+	message.encode(&value[offset]);
+}
+
+/**
+ * FUNCTION NAME: decodeNext
+ *
+ * DESCRIPTION: Decode the first message left in the value of a batch and drop it from batch
+ *
+ * RETURNS:
+ * false once the batch is exhausted or malformed
+ */
+bool Message::decodeNext(StringView *batch, MessageView *view){
+	if ( !decode(batch->data(), batch->size(), view) ) {
+		return false;
+	}
+
+	int used = encodedSize(*view);
+	*batch = StringView(batch->data() + used, batch->size() - used);
+	return true;
 }
 
 /**
  * Assignment operator overloading
  */
 Message& Message::operator =(const Message& anotherMessage) {
-	this->delimiter = anotherMessage.delimiter;
 	this->fromAddr = anotherMessage.fromAddr;
 	this->key = anotherMessage.key;
 	this->replica = anotherMessage.replica;
 	this->success = anotherMessage.success;
 	this->transID = anotherMessage.transID;
+	this->timestamp = anotherMessage.timestamp;
 	this->type = anotherMessage.type;
 	this->value = anotherMessage.value;
 	return *this;
@@ -9,6 +9,40 @@
 #include "stdincludes.h"
 #include "Member.h"
 #include "common.h"
+#include "StringView.h"
+
+/**
+ * Wire format of a message, integers in host byte order:
+ * 		version		1 byte, MESSAGE_VERSION
+ * 		type		1 byte, MessageType
+ * 		replica		1 byte, ReplicaType
+ * 		success		1 byte
+ * 		transID		4 bytes
+ * 		timestamp	4 bytes, version of the value written by a CREATE or UPDATE
+ * 		fromAddr	6 bytes
+ * 		key length	4 bytes, followed by the key
+ * 		value length	4 bytes, followed by the value
+ * The value of a BATCH or BATCHREPLY message holds the encodings of the messages it
+ * groups, back to back.
+ */
+#define MESSAGE_VERSION 2
+#define MESSAGE_HEADER_SIZE 26
+
+/**
+ * STRUCT NAME: MessageView
+ *
+ * DESCRIPTION: Decoded message whose key and value point into the receive buffer
+ */
+typedef struct MessageView {
+	MessageType type;
+	ReplicaType replica;
+	bool success;
+	int transID;
+	int timestamp;
+	Address fromAddr;
+	StringView key;
+	StringView value;
+}MessageView;
 
 /**
  * CLASS NAME: Message
@@ -23,11 +57,10 @@ public:
 	string value;
 	Address fromAddr;
 	int transID;
+	int timestamp; // version of the value written
 	bool success; // success or not 
-	// delimiter
-	string delimiter;
-	// construct a message from a string
-	Message(string message);
+	// construct a message from a decoded view
+	Message(const MessageView &view);
 	Message(const Message& anotherMessage);
 	// construct a create or update message
 	Message(int _transID, Address _fromAddr, MessageType _type, string _key, string _value);
@@ -39,8 +72,15 @@ public:
 	// construct read reply message
 	Message(int _transID, Address _fromAddr, string _value);
 	Message& operator = (const Message& anotherMessage);
-	// serialize to a string
-	string toString();
+	// serialize into a buffer of at least encodedSize() bytes
+	int encodedSize();
+	int encode(char *buffer);
+	static int encodedSize(const MessageView &view);
+	// decode without copying the key and value
+	static bool decode(const char *data, int size, MessageView *view);
+	// add a message to the value of a batch, and take the messages of a batch one at a time
+	void append(Message &message);
+	static bool decodeNext(StringView *batch, MessageView *view);
 };
 
 #endif
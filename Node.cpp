@@ -30,7 +30,24 @@ Node::~Node() {}
  * DESCRIPTION: This function computes the hash code of the node address
  */
 void Node::computeHashCode() {
-	nodeHashCode = hashFunc(nodeAddress.addr)%RING_SIZE;
+	nodeHashCode = ringHash(nodeAddress.addr, sizeof(nodeAddress.addr));
+}
+
+/**
+ * FUNCTION NAME: getTokenHashCode
+ *
+ * DESCRIPTION: Ring position of the given virtual node of this node. Token 0 is the
+ * 				node's own hash code; the others hash the address followed by the token.
+ */
+unsigned long long Node::getTokenHashCode(int token) {
+	char tagged[sizeof(nodeAddress.addr) + sizeof(int)];
+
+	if ( token == 0 ) {
+		return nodeHashCode;
+	}
+	memcpy(tagged, nodeAddress.addr, sizeof(nodeAddress.addr));
+	memcpy(tagged + sizeof(nodeAddress.addr), &token, sizeof(int));
+	return ringHash(tagged, sizeof(tagged));
 }
 
 /**
@@ -62,7 +79,7 @@ bool Node::operator < (const Node& another) const {
  *
  * DESCRIPTION: return hash code of the node
  */
-size_t Node::getHashCode() {
+unsigned long long Node::getHashCode() {
 	return nodeHashCode;
 }
 
@@ -80,7 +97,7 @@ Address * Node::getAddress() {
  *
  * DESCRIPTION: set the hash code of the node
  */
-void Node::setHashCode(size_t hashCode) {
+void Node::setHashCode(unsigned long long hashCode) {
 	this->nodeHashCode = hashCode;
 }
 
@@ -9,21 +9,22 @@
 
 #include "stdincludes.h"
 #include "Member.h"
+#include "Hash.h"
 
 class Node {
 public:
 	Address nodeAddress;
-	size_t nodeHashCode;
-	std::hash<string> hashFunc;
+	unsigned long long nodeHashCode;
 	Node();
 	Node(Address address);
 	Node(const Node& another);
 	Node& operator=(const Node& another);
 	bool operator < (const Node& another) const;
 	void computeHashCode();
-	size_t getHashCode();
+	unsigned long long getTokenHashCode(int token);
+	unsigned long long getHashCode();
 	Address * getAddress();
-	void setHashCode(size_t hashCode);
+	void setHashCode(unsigned long long hashCode);
 	void setAddress(Address address);
 	virtual ~Node();
 };
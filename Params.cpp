@@ -18,16 +18,118 @@ Params::Params(): PORTNUM(8001) {}
  */
 void Params::setparams(char *config_file) {
 	//trace.funcEntry("Params::setparams");
-	char CRUD[10];
+	char CRUD[CONFIG_WORD_SIZE] = "";
+	char DETECTOR[CONFIG_WORD_SIZE] = "GOSSIP";
+	char HASH[CONFIG_WORD_SIZE] = "XXH64";
+	char READ_LEVEL[CONFIG_WORD_SIZE] = "QUORUM";
+	char WRITE_LEVEL[CONFIG_WORD_SIZE] = "QUORUM";
+	char LINE[CONFIG_LINE_SIZE];
+	char KEY[CONFIG_LINE_SIZE];
+	char VALUE[CONFIG_LINE_SIZE];
+	char EXTRA;
+	bool sawMaxNnb = false;
 	FILE *fp = fopen(config_file,"r");
 
-	fscanf(fp,"MAX_NNB: %d", &MAX_NNB);
-	fscanf(fp,"\nSINGLE_FAILURE: %d", &SINGLE_FAILURE);
-	fscanf(fp,"\nDROP_MSG: %d", &DROP_MSG);
-	fscanf(fp,"\nMSG_DROP_PROB: %lf", &MSG_DROP_PROB);
-	fscanf(fp,"\nCRUD_TEST: %s", CRUD);
+	if ( fp == NULL ) {
+		configError(config_file, "", "cannot be opened");
+	}
+
+	// Every key but MAX_NNB keeps these defaults when absent from the config file
+	SINGLE_FAILURE = 0;
+	DROP_MSG = 0;
+	MSG_DROP_PROB = 0;
+	GOSSIP_FANOUT = 0;
+	GOSSIP_PERIOD = 1;
+	GOSSIP_FULL_SYNC = 0;
+	SWIM_INDIRECT_PROBES = 3;
+	PHI_THRESHOLD = 8.0;
+	VNODES = 1;
+	REPLICATION_FACTOR = 3;
+	WAL = 0;
+	VALUE_SIZE = 0;
+
+	// Keys may come in any order, one "KEY: value" per line, and each line is matched by name
+	while ( fgets(LINE, sizeof(LINE), fp) != NULL ) {
+		if ( strchr(LINE, '\n') == NULL && !feof(fp) ) {
+			configError(config_file, LINE, "line too long");
+		}
+		LINE[strcspn(LINE, "\r\n")] = '\0';
+		int fields = sscanf(LINE, " %[^: \t] : %s %c", KEY, VALUE, &EXTRA);
+		if ( fields <= 0 ) {
+			// Blank line
+			continue;
+		}
+		if ( fields != 2 ) {
+			configError(config_file, LINE, "expected KEY: value");
+		}
+
+		if ( 0 == strcmp(KEY, "MAX_NNB") ) {
+			MAX_NNB = parseInt(config_file, KEY, VALUE);
+			sawMaxNnb = true;
+		}
+		else if ( 0 == strcmp(KEY, "SINGLE_FAILURE") ) {
+			SINGLE_FAILURE = parseInt(config_file, KEY, VALUE);
+		}
+		else if ( 0 == strcmp(KEY, "DROP_MSG") ) {
+			DROP_MSG = parseInt(config_file, KEY, VALUE);
+		}
+		else if ( 0 == strcmp(KEY, "MSG_DROP_PROB") ) {
+			MSG_DROP_PROB = parseDouble(config_file, KEY, VALUE);
+		}
+		else if ( 0 == strcmp(KEY, "CRUD_TEST") ) {
+			parseWord(config_file, KEY, VALUE, CRUD);
+		}
+		else if ( 0 == strcmp(KEY, "GOSSIP_FANOUT") ) {
+			GOSSIP_FANOUT = parseInt(config_file, KEY, VALUE);
+		}
+		else if ( 0 == strcmp(KEY, "GOSSIP_PERIOD") ) {
+			GOSSIP_PERIOD = parseInt(config_file, KEY, VALUE);
+		}
+		else if ( 0 == strcmp(KEY, "GOSSIP_FULL_SYNC") ) {
+			GOSSIP_FULL_SYNC = parseInt(config_file, KEY, VALUE);
+		}
+		else if ( 0 == strcmp(KEY, "FAILURE_DETECTOR") ) {
+			parseWord(config_file, KEY, VALUE, DETECTOR);
+		}
+		else if ( 0 == strcmp(KEY, "SWIM_INDIRECT_PROBES") ) {
+			SWIM_INDIRECT_PROBES = parseInt(config_file, KEY, VALUE);
+		}
+		else if ( 0 == strcmp(KEY, "PHI_THRESHOLD") ) {
+			PHI_THRESHOLD = parseDouble(config_file, KEY, VALUE);
+		}
+		else if ( 0 == strcmp(KEY, "VNODES") ) {
+			VNODES = parseInt(config_file, KEY, VALUE);
+		}
+		else if ( 0 == strcmp(KEY, "RING_HASH") ) {
+			parseWord(config_file, KEY, VALUE, HASH);
+		}
+		else if ( 0 == strcmp(KEY, "REPLICATION_FACTOR") ) {
+			REPLICATION_FACTOR = parseInt(config_file, KEY, VALUE);
+		}
+		else if ( 0 == strcmp(KEY, "READ_CONSISTENCY") ) {
+			parseWord(config_file, KEY, VALUE, READ_LEVEL);
+		}
+		else if ( 0 == strcmp(KEY, "WRITE_CONSISTENCY") ) {
+			parseWord(config_file, KEY, VALUE, WRITE_LEVEL);
+		}
+		else if ( 0 == strcmp(KEY, "WAL") ) {
+			WAL = parseInt(config_file, KEY, VALUE);
+		}
+		else if ( 0 == strcmp(KEY, "VALUE_SIZE") ) {
+			VALUE_SIZE = parseInt(config_file, KEY, VALUE);
+		}
+		else {
+			configError(config_file, KEY, "unknown key");
+		}
+	}
+	if ( !sawMaxNnb ) {
+		configError(config_file, "MAX_NNB", "missing");
+	}
 
-	if ( 0 == strcmp(CRUD, "CREATE") ) {
+	if ( 0 == strcmp(CRUD, "") ) {
+		this->CRUDTEST = NO_TEST;
+	}
+	else if ( 0 == strcmp(CRUD, "CREATE") ) {
 		this->CRUDTEST = CREATE_TEST;
 	}
 	else if ( 0 == strcmp(CRUD, "READ") ) {
@@ -39,12 +141,65 @@ void Params::setparams(char *config_file) {
 	else if ( 0 == strcmp(CRUD, "DELETE") ) {
 		this->CRUDTEST = DELETE_TEST;
 	}
+	else if ( 0 == strcmp(CRUD, "BATCH") ) {
+		this->CRUDTEST = BATCH_TEST;
+	}
+	else if ( 0 == strcmp(CRUD, "RESTART") ) {
+		this->CRUDTEST = RESTART_TEST;
+	}
+	else {
+		configError(config_file, "CRUD_TEST", "unknown test");
+	}
+
+	if ( 0 == strcmp(DETECTOR, "SWIM") ) {
+		this->FAILURE_DETECTOR = SWIM_DETECTOR;
+	}
+	else if ( 0 == strcmp(DETECTOR, "PHI") ) {
+		this->FAILURE_DETECTOR = PHI_DETECTOR;
+	}
+	else if ( 0 == strcmp(DETECTOR, "GOSSIP") ) {
+		this->FAILURE_DETECTOR = GOSSIP_DETECTOR;
+	}
+	else {
+		configError(config_file, "FAILURE_DETECTOR", "unknown detector");
+	}
+
+	if ( 0 == strcmp(HASH, "STD") ) {
+		this->RING_HASH = STD_HASH;
+	}
+	else if ( 0 == strcmp(HASH, "FNV") ) {
+		this->RING_HASH = FNV1A_HASH;
+	}
+	else if ( 0 == strcmp(HASH, "XXH64") ) {
+		this->RING_HASH = XXH64_HASH;
+	}
+	else {
+		configError(config_file, "RING_HASH", "unknown hash");
+	}
+
+	this->READ_CONSISTENCY = parseConsistency(READ_LEVEL);
+	this->WRITE_CONSISTENCY = parseConsistency(WRITE_LEVEL);
+	if ( this->READ_CONSISTENCY < 0 ) {
+		configError(config_file, "READ_CONSISTENCY", "unknown level");
+	}
+	if ( this->WRITE_CONSISTENCY < 0 ) {
+		configError(config_file, "WRITE_CONSISTENCY", "unknown level");
+	}
 
 	//printf("Parameters of the test case: %d %d %d %lf\n", MAX_NNB, SINGLE_FAILURE, DROP_MSG, MSG_DROP_PROB);
 
 	EN_GPSZ = MAX_NNB;
 	STEP_RATE=.25;
 	MAX_MSG_SIZE = 4000;
+	if ( GOSSIP_PERIOD < 1 ) {
+		GOSSIP_PERIOD = 1;
+	}
+	if ( VNODES < 1 ) {
+		VNODES = 1;
+	}
+	if ( REPLICATION_FACTOR < 1 ) {
+		REPLICATION_FACTOR = 1;
+	}
 	globaltime = 0;
 	dropmsg = 0;
 	allNodesJoined = 0;
@@ -65,3 +220,77 @@ void Params::setparams(char *config_file) {
 int Params::getcurrtime(){
     return globaltime;
 }
+
+/**
+ * FUNCTION NAME: parseConsistency
+ *
+ * DESCRIPTION: Map a consistency level name from the config file to a ConsistencyLevel
+ *
+ * RETURNS:
+ * -1 for unknown names
+ */
+int Params::parseConsistency(const char *level) {
+	if ( 0 == strcmp(level, "ONE") ) {
+		return ONE;
+	}
+	else if ( 0 == strcmp(level, "ALL") ) {
+		return ALL;
+	}
+	else if ( 0 == strcmp(level, "QUORUM") ) {
+		return QUORUM;
+	}
+	return -1;
+}
+
+/**
+ * FUNCTION NAME: configError
+ *
+ * DESCRIPTION: Report a bad config file and stop, as a test run with wrong parameters is meaningless
+ */
+void Params::configError(const char *config_file, const char *what, const char *problem) {
+	cout<<config_file<<": "<<what<<(what[0] ? ": " : "")<<problem<<endl;
+	exit(1);
+}
+
+/**
+ * FUNCTION NAME: parseInt
+ *
+ * DESCRIPTION: Parse the integer value of a config key, rejecting anything else
+ */
+int Params::parseInt(const char *config_file, const char *key, const char *value) {
+	char *end;
+	errno = 0;
+	long number = strtol(value, &end, 10);
+	if ( *end != '\0' || errno != 0 || number < INT_MIN || number > INT_MAX ) {
+		configError(config_file, key, "expected an integer");
+	}
+	return (int) number;
+}
+
+/**
+ * FUNCTION NAME: parseDouble
+ *
+ * DESCRIPTION: Parse the real value of a config key, rejecting anything else
+ */
+double Params::parseDouble(const char *config_file, const char *key, const char *value) {
+	char *end;
+	errno = 0;
+	double number = strtod(value, &end);
+	if ( *end != '\0' || errno != 0 ) {
+		configError(config_file, key, "expected a number");
+	}
+	return number;
+}
+
+/**
+ * FUNCTION NAME: parseWord
+ *
+ * DESCRIPTION: Copy the word value of a config key into a CONFIG_WORD_SIZE buffer,
+ * 				rejecting values that would not fit instead of truncating them
+ */
+void Params::parseWord(const char *config_file, const char *key, const char *value, char *word) {
+	if ( strlen(value) >= CONFIG_WORD_SIZE ) {
+		configError(config_file, key, "value too long");
+	}
+	strcpy(word, value);
+}
@@ -10,8 +10,15 @@
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "Hash.h"
+#include "common.h"
 
-enum testTYPE { CREATE_TEST, READ_TEST, UPDATE_TEST, DELETE_TEST };
+enum testTYPE { CREATE_TEST, READ_TEST, UPDATE_TEST, DELETE_TEST, BATCH_TEST, RESTART_TEST, NO_TEST };
+
+// Longest config line, and longest word value (CRUD_TEST, FAILURE_DETECTOR, ...) plus its terminator
+#define CONFIG_LINE_SIZE 256
+#define CONFIG_WORD_SIZE 10
+enum detectorTYPE { GOSSIP_DETECTOR, SWIM_DETECTOR, PHI_DETECTOR };
 
 /**
  * CLASS NAME: Params
@@ -32,8 +39,26 @@ public:
 	int allNodesJoined;
 	short PORTNUM;
 	int CRUDTEST;
+	int GOSSIP_FANOUT;          // peers gossiped to per round, 0 for all members
+	int GOSSIP_PERIOD;          // time units between gossip rounds
+	int GOSSIP_FULL_SYNC;       // rounds between full membership syncs, 0 to always send the full list
+	int FAILURE_DETECTOR;       // heartbeat gossip, SWIM probing or phi-accrual over gossip
+	int SWIM_INDIRECT_PROBES;   // members asked to probe a target that missed its ack
+	double PHI_THRESHOLD;       // suspicion level at which the phi-accrual detector removes a member
+	int VNODES;                 // ring positions (tokens) of each node in the key-value store
+	int RING_HASH;              // hash function placing keys and tokens on the ring (see Hash.h)
+	int REPLICATION_FACTOR;     // nodes holding a copy of each key (N)
+	int READ_CONSISTENCY;       // default replies a read waits for (R, see ConsistencyLevel in common.h)
+	int WRITE_CONSISTENCY;      // default replies a create, update or delete waits for (W)
+	int WAL;                    // 1 to log each node's writes ahead to disk and replay them when it restarts
+	int VALUE_SIZE;             // length the test values are padded to, 0 to leave them short
 	Params();
 	void setparams(char *);
+	static int parseConsistency(const char *level);
+	static void configError(const char *config_file, const char *what, const char *problem);
+	static int parseInt(const char *config_file, const char *key, const char *value);
+	static double parseDouble(const char *config_file, const char *key, const char *value);
+	static void parseWord(const char *config_file, const char *key, const char *value, char *word);
 	int getcurrtime();
 };
 
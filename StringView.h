@@ -0,0 +1,46 @@
+/**********************************
+ * FILE NAME: StringView.h
+ *
+ * DESCRIPTION: Non-owning view of a sequence of characters
+ **********************************/
+
+#ifndef STRINGVIEW_H_
+#define STRINGVIEW_H_
+
+#include "stdincludes.h"
+
+/**
+ * CLASS NAME: StringView
+ *
+ * DESCRIPTION: Pointer and length into characters owned by someone else, such as a
+ * 				receive buffer or a string. It is only valid while that owner is.
+ */
+class StringView {
+	const char *ptr;
+	size_t len;
+public:
+	StringView(): ptr(""), len(0) {}
+	StringView(const char *data, size_t length): ptr(data), len(length) {}
+	StringView(const char *str): ptr(str), len(strlen(str)) {}
+	StringView(const string &str): ptr(str.data()), len(str.size()) {}
+	const char *data() const {
+		return ptr;
+	}
+	size_t size() const {
+		return len;
+	}
+	bool empty() const {
+		return len == 0;
+	}
+	string toString() const {
+		return string(ptr, len);
+	}
+	bool operator ==(const StringView &another) const {
+		return len == another.len && memcmp(ptr, another.ptr, len) == 0;
+	}
+	bool operator !=(const StringView &another) const {
+		return !(*this == another);
+	}
+};
+
+#endif /* STRINGVIEW_H_ */
@@ -0,0 +1,144 @@
+/**********************************
+ * FILE NAME: TimerWheel.cpp
+ *
+ * DESCRIPTION: TimerWheel class definition
+ **********************************/
+
+#include "TimerWheel.h"
+
+#define NO_TIMER -1
+
+TimerWheel::TimerWheel(int slotCount, long startTime) {
+	unsigned long count = 1;
+	while ( count < (unsigned long) slotCount ) {
+		count <<= 1;
+	}
+	slots.assign(count, NO_TIMER);
+	mask = count - 1;
+	freeList = NO_TIMER;
+	current = startTime;
+	active = 0;
+}
+
+TimerWheel::~TimerWheel() {}
+
+/**
+ * FUNCTION NAME: schedule
+ *
+ * DESCRIPTION: Arm a timer for a key. A deadline that already passed fires on the next advance.
+ *
+ * RETURNS:
+ * handle of the timer, valid until it fires or is cancelled
+ */
+int TimerWheel::schedule(unsigned long long key, long deadline) {
+	int handle;
+
+	if ( freeList != NO_TIMER ) {
+		handle = freeList;
+		freeList = timers[handle].next;
+	}
+	else {
+		handle = timers.size();
+		timers.push_back(Timer());
+	}
+
+	timers[handle].key = key;
+	timers[handle].deadline = deadline;
+	link(handle);
+	active++;
+	return handle;
+}
+
+/**
+ * FUNCTION NAME: reschedule
+ *
+ * DESCRIPTION: Move an armed timer to a new deadline
+ */
+void TimerWheel::reschedule(int handle, long deadline) {
+	unlink(handle);
+	timers[handle].deadline = deadline;
+	link(handle);
+}
+
+/**
+ * FUNCTION NAME: cancel
+ *
+ * DESCRIPTION: Disarm a timer and release its handle
+ */
+void TimerWheel::cancel(int handle) {
+	unlink(handle);
+	timers[handle].next = freeList;
+	freeList = handle;
+	active--;
+}
+
+/**
+ * FUNCTION NAME: advance
+ *
+ * DESCRIPTION: Move the wheel forward to the given time, appending the key of every timer
+ * 				that became due to the vector. Fired timers are released.
+ */
+void TimerWheel::advance(long now, vector<unsigned long long> &due) {
+	long last = min(now, current + (long) slots.size());
+
+	for ( long t = current + 1; t <= last; t++ ) {
+		int handle = slots[t & mask];
+		while ( handle != NO_TIMER ) {
+			int next = timers[handle].next;
+			if ( timers[handle].deadline <= now ) {
+				due.push_back(timers[handle].key);
+				cancel(handle);
+			}
+			handle = next;
+		}
+	}
+
+	if ( now > current ) {
+		current = now;
+	}
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Number of armed timers
+ */
+unsigned long TimerWheel::size() const {
+	return active;
+}
+
+/**
+ * FUNCTION NAME: link
+ *
+ * DESCRIPTION: Push a timer at the head of the slot of its deadline
+ */
+void TimerWheel::link(int handle) {
+	long when = max(timers[handle].deadline, current + 1);
+	int &head = slots[when & mask];
+
+	timers[handle].prev = NO_TIMER;
+	timers[handle].next = head;
+	if ( head != NO_TIMER ) {
+		timers[head].prev = handle;
+	}
+	head = handle;
+}
+
+/**
+ * FUNCTION NAME: unlink
+ *
+ * DESCRIPTION: Take a timer out of its slot list
+ */
+void TimerWheel::unlink(int handle) {
+	Timer &timer = timers[handle];
+
+	if ( timer.prev != NO_TIMER ) {
+		timers[timer.prev].next = timer.next;
+	}
+	else {
+		slots[max(timer.deadline, current + 1) & mask] = timer.next;
+	}
+	if ( timer.next != NO_TIMER ) {
+		timers[timer.next].prev = timer.prev;
+	}
+}
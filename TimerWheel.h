@@ -0,0 +1,53 @@
+/**********************************
+ * FILE NAME: TimerWheel.h
+ *
+ * DESCRIPTION: Header file TimerWheel class
+ **********************************/
+
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+
+/**
+ * Header files
+ */
+#include "stdincludes.h"
+
+/**
+ * CLASS NAME: TimerWheel
+ *
+ * DESCRIPTION: Hashed timing wheel. A timer due at time t is linked into slot t mod the
+ * 				slot count; advancing the wheel by one time unit only visits the timers
+ * 				of that slot, firing those that are due and leaving the ones due on a
+ * 				later revolution. Timers are identified by the handle schedule returns,
+ * 				and can be cancelled or moved in O(1).
+ */
+class TimerWheel {
+private:
+	struct Timer {
+		unsigned long long key;
+		long deadline;
+		int prev;
+		int next;
+	};
+	// Timer pool; free timers are chained through next
+	vector<Timer> timers;
+	int freeList;
+	// Head of the timer list of each slot
+	vector<int> slots;
+	unsigned long mask;
+	// Last time the wheel was advanced to
+	long current;
+	unsigned long active;
+	void link(int handle);
+	void unlink(int handle);
+public:
+	TimerWheel(int slotCount = 64, long startTime = 0);
+	int schedule(unsigned long long key, long deadline);
+	void reschedule(int handle, long deadline);
+	void cancel(int handle);
+	void advance(long now, vector<unsigned long long> &due);
+	unsigned long size() const;
+	virtual ~TimerWheel();
+};
+
+#endif /* TIMERWHEEL_H_ */
@@ -0,0 +1,248 @@
+/**********************************
+ * FILE NAME: WriteAheadLog.cpp
+ *
+ * DESCRIPTION: WriteAheadLog class definition
+ **********************************/
+
+#include "WriteAheadLog.h"
+
+/**
+ * constructor
+ *
+ * DESCRIPTION: Open the log at path, creating it if it does not exist, and emptying it
+ * 				if truncate is set
+ */
+WriteAheadLog::WriteAheadLog(const string &path, bool truncate): path(path), fileSize(0) {
+	fd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0), 0644);
+	if ( fd < 0 ) {
+		perror(path.c_str());
+		return;
+	}
+	off_t end = lseek(fd, 0, SEEK_END);
+	if ( end > 0 ) {
+		fileSize = end;
+	}
+}
+
+/**
+ * Destructor
+ */
+WriteAheadLog::~WriteAheadLog() {
+	commit();
+	if ( fd >= 0 ) {
+		close(fd);
+	}
+}
+
+/**
+ * FUNCTION NAME: load
+ *
+ * DESCRIPTION: Read the records already in the log into contents, for replay with decodeNext.
+ * 				A torn record at the end is dropped from contents and cut off the file.
+ *
+ * RETURNS:
+ * false if the log could not be read
+ */
+bool WriteAheadLog::load(string &contents) {
+	char buffer[4096];
+	ssize_t bytes;
+
+	contents.clear();
+	if ( fd < 0 || lseek(fd, 0, SEEK_SET) < 0 ) {
+		return false;
+	}
+	while ( (bytes = read(fd, buffer, sizeof(buffer))) != 0 ) {
+		if ( bytes < 0 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			return false;
+		}
+		contents.append(buffer, bytes);
+	}
+
+	StringView log(contents);
+	WalRecordView record;
+	while ( decodeNext(&log, &record) );
+
+	size_t whole = contents.size() - log.size();
+	if ( whole < contents.size() ) {
+		contents.resize(whole);
+		if ( ftruncate(fd, whole) < 0 ) {
+			perror(path.c_str());
+		}
+	}
+	fileSize = whole;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: decodeNext
+ *
+ * DESCRIPTION: Decode the first record left in log and drop it from log
+ *
+ * RETURNS:
+ * false once the log is exhausted or its next record is torn
+ */
+bool WriteAheadLog::decodeNext(StringView *log, WalRecordView *record) {
+	unsigned int keyLength, entryLength;
+
+	if ( log->size() < WAL_RECORD_HEADER_SIZE ) {
+		return false;
+	}
+	const char *data = log->data();
+	record->type = data[0];
+	memcpy(&keyLength, data + 1, sizeof(int));
+	memcpy(&entryLength, data + 1 + sizeof(int), sizeof(int));
+
+	size_t used = WAL_RECORD_HEADER_SIZE + (size_t) keyLength + entryLength;
+	if ( (record->type != WAL_PUT && record->type != WAL_DELETE) || used > log->size() ) {
+		return false;
+	}
+	record->key = StringView(data + WAL_RECORD_HEADER_SIZE, keyLength);
+	record->entry = StringView(data + WAL_RECORD_HEADER_SIZE + keyLength, entryLength);
+	*log = StringView(data + used, log->size() - used);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: encode
+ *
+ * DESCRIPTION: Add the encoding of a record to buffer
+ */
+void WriteAheadLog::encode(char type, StringView key, StringView entry, string &buffer) {
+	unsigned int keyLength = key.size();
+	unsigned int entryLength = entry.size();
+
+	buffer.push_back(type);
+	buffer.append((const char *) &keyLength, sizeof(int));
+	buffer.append((const char *) &entryLength, sizeof(int));
+	buffer.append(key.data(), key.size());
+	buffer.append(entry.data(), entry.size());
+}
+
+/**
+ * FUNCTION NAME: append
+ *
+ * DESCRIPTION: Buffer a record until the next commit
+ */
+void WriteAheadLog::append(char type, StringView key, StringView entry) {
+	encode(type, key, entry, pending);
+}
+
+/**
+ * FUNCTION NAME: appendPut
+ *
+ * DESCRIPTION: Log that key was written with the given stored entry
+ */
+void WriteAheadLog::appendPut(StringView key, StringView entry) {
+	append(WAL_PUT, key, entry);
+}
+
+/**
+ * FUNCTION NAME: appendDelete
+ *
+ * DESCRIPTION: Log that key was deleted
+ */
+void WriteAheadLog::appendDelete(StringView key) {
+	append(WAL_DELETE, key, StringView());
+}
+
+/**
+ * FUNCTION NAME: commit
+ *
+ * DESCRIPTION: Write the records appended since the last commit and fsync them, at once
+ *
+ * RETURNS:
+ * false if the records could not be made durable
+ */
+bool WriteAheadLog::commit() {
+	size_t written = 0;
+
+	if ( pending.empty() ) {
+		return true;
+	}
+	if ( fd < 0 ) {
+		return false;
+	}
+	while ( written < pending.size() ) {
+		ssize_t bytes = write(fd, pending.data() + written, pending.size() - written);
+		if ( bytes < 0 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			perror(path.c_str());
+			pending.erase(0, written);
+			fileSize += written;
+			return false;
+		}
+		written += bytes;
+	}
+	fileSize += written;
+	pending.clear();
+	if ( fsync(fd) < 0 ) {
+		perror(path.c_str());
+		return false;
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: rewrite
+ *
+ * DESCRIPTION: Replace the log with the given records, a checkpoint that already holds every
+ * 				write appended so far, uncommitted ones included. The checkpoint is written
+ * 				and fsynced to a temporary file renamed over the log, so a crash leaves
+ * 				either the old log or the whole checkpoint.
+ *
+ * RETURNS:
+ * false if the log was left as it was
+ */
+bool WriteAheadLog::rewrite(const string &records) {
+	string temporary = path + ".tmp";
+	size_t written = 0;
+
+	int out = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if ( out < 0 ) {
+		perror(temporary.c_str());
+		return false;
+	}
+	while ( written < records.size() ) {
+		ssize_t bytes = write(out, records.data() + written, records.size() - written);
+		if ( bytes < 0 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			break;
+		}
+		written += bytes;
+	}
+	if ( written < records.size() || fsync(out) < 0 || rename(temporary.c_str(), path.c_str()) < 0 ) {
+		perror(temporary.c_str());
+		close(out);
+		unlink(temporary.c_str());
+		return false;
+	}
+	close(out);
+
+	// Later appends go to the checkpoint
+	if ( fd >= 0 ) {
+		close(fd);
+	}
+	fd = open(path.c_str(), O_RDWR | O_APPEND);
+	if ( fd < 0 ) {
+		perror(path.c_str());
+	}
+	pending.clear();
+	fileSize = records.size();
+	return true;
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Bytes in the log file, records appended but not committed left out
+ */
+unsigned long WriteAheadLog::size() const {
+	return fileSize;
+}
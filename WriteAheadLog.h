@@ -0,0 +1,73 @@
+/**********************************
+ * FILE NAME: WriteAheadLog.h
+ *
+ * DESCRIPTION: Header file WriteAheadLog class
+ **********************************/
+
+#ifndef WRITEAHEADLOG_H_
+#define WRITEAHEADLOG_H_
+
+/**
+ * Header files
+ */
+#include "stdincludes.h"
+#include "StringView.h"
+
+/**
+ * Record layout:
+ * 		type		1 byte, WAL_PUT or WAL_DELETE
+ * 		key length	4 bytes
+ * 		entry length	4 bytes, 0 for a delete
+ * 		key
+ * 		entry		stored form of the Entry written (see Entry.h)
+ */
+#define WAL_RECORD_HEADER_SIZE 9
+#define WAL_PUT 1
+#define WAL_DELETE 2
+
+/**
+ * STRUCT NAME: WalRecordView
+ *
+ * DESCRIPTION: Decoded record whose key and entry point into the replayed log
+ */
+typedef struct WalRecordView {
+	char type;
+	StringView key;
+	StringView entry;
+}WalRecordView;
+
+/**
+ * CLASS NAME: WriteAheadLog
+ *
+ * DESCRIPTION: Append-only log of the writes applied to a node's hash table.
+ * 				Records are buffered as they are appended and reach the disk with a
+ * 				single write and fsync per commit (group commit), which the node
+ * 				issues once per tick, before any reply it sent in that tick can be
+ * 				delivered. A node starting fresh truncates the log; a node restarting
+ * 				after a failure loads it for replay, and a record torn by the crash is
+ * 				cut off so later appends follow the last whole one. rewrite replaces
+ * 				the whole log with a checkpoint, atomically.
+ */
+class WriteAheadLog {
+private:
+	int fd;
+	string path;
+	// Records appended since the last commit
+	string pending;
+	// Bytes in the log file
+	unsigned long fileSize;
+	void append(char type, StringView key, StringView entry);
+public:
+	WriteAheadLog(const string &path, bool truncate);
+	bool load(string &contents);
+	static bool decodeNext(StringView *log, WalRecordView *record);
+	static void encode(char type, StringView key, StringView entry, string &buffer);
+	void appendPut(StringView key, StringView entry);
+	void appendDelete(StringView key);
+	bool commit();
+	bool rewrite(const string &records);
+	unsigned long size() const;
+	virtual ~WriteAheadLog();
+};
+
+#endif /* WRITEAHEADLOG_H_ */
@@ -8,8 +8,12 @@
 static int g_transID = 0;
 
 // message types, reply is the message from node to coordinator
-enum MessageType {CREATE, READ, UPDATE, DELETE, REPLY, READREPLY};
+// a batch groups several messages for the same node, a batch reply groups their replies;
+// a digest offers a key at a version during stabilization, and the receiver pulls it if its copy is older
+enum MessageType {CREATE, READ, UPDATE, DELETE, REPLY, READREPLY, BATCH, BATCHREPLY, DIGEST, PULL};
 // enum of replica types
 enum ReplicaType {PRIMARY, SECONDARY, TERTIARY};
+// replies a coordinator waits for: one replica, a majority of the replicas, or every replica
+enum ConsistencyLevel {ONE, QUORUM, ALL};
 
 #endif